@@ -1,9 +1,57 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "defs.h"
 #include "movegen.h"
+#include "search.h"
+#include "batch.h"
+#include "bench.h"
+#include "nnue.h"
+
+static void print_usage() {
+    printf("usage: scylla [--nnue <file>] bench [depth] [threads] [hash_mb]\n");
+    printf("       scylla [--nnue <file>] batch <input> <output> [depth] [threads] [hash_mb] [nodes]\n");
+}
+
+int main(int argc, char* argv[]) {
+    init_engine();
+
+    // Evaluate with a network instead of the classical evaluation
+    if (argc >= 3 && strcmp(argv[1], "--nnue") == 0) {
+        if (!nnue_load(argv[2])) {
+            fprintf(stderr, "can't load network %s\n", argv[2]);
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc < 2) {
+        return 0;
+    }
 
+    // Fixed-depth search of the built-in positions: node signature and speed
+    if (strcmp(argv[1], "bench") == 0) {
+        int depth = argc > 2 ? atoi(argv[2]) : 0;
+        int threads = argc > 3 ? atoi(argv[3]) : 1;
+        int hash_mb = argc > 4 ? atoi(argv[4]) : 0;
+        return run_bench(depth, threads, hash_mb) == 0 ? 0 : 1;
+    }
 
-int main() {
-    init_attack_tables();
+    // Analyse a FEN/EPD file on a pool of workers
+    if (strcmp(argv[1], "batch") == 0 && argc >= 4) {
+        BatchOptions options = {
+            .input_path = argv[2],
+            .output_path = argv[3],
+            .depth = argc > 4 ? atoi(argv[4]) : 0,
+            .threads = argc > 5 ? atoi(argv[5]) : 1,
+            .hash_mb = argc > 6 ? atoi(argv[6]) : 0,
+            .nodes = argc > 7 ? atol(argv[7]) : 0,
+        };
+        return run_batch(&options) == 0 ? 0 : 1;
+    }
 
-    return 0;
-}
\ No newline at end of file
+    print_usage();
+    return 1;
+}
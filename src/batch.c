@@ -0,0 +1,308 @@
+// src/batch.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#include "batch.h"
+#include "board.h"
+#include "search.h"
+
+#define BATCH_LINE_LENGTH 1024
+#define BATCH_RESULT_LENGTH 4096
+// Results that may wait for a slow earlier position before workers stall
+#define BATCH_WINDOW_PER_THREAD 16
+// Deep searches recurse with a MoveList per ply; don't rely on the default
+#define BATCH_STACK_SIZE (16 << 20)
+
+// Shared between the workers. Lines are handed out in order under 'lock',
+// and finished results are parked in a ring of 'window' slots until every
+// earlier line has been written.
+typedef struct {
+    const BatchOptions* options;
+    FILE* input;
+    FILE* output;
+
+    pthread_mutex_t lock;
+    pthread_cond_t slot_free;
+    long next_index;     // Index of the next line to hand out
+    long next_to_write;  // Index of the next result the output is waiting for
+    int input_done;
+    char** results;      // Ring buffer, NULL while a result is pending
+    int window;
+
+    long positions;
+    long invalid;
+    long total_nodes;
+} BatchState;
+
+// parse_fen() trusts its input, so malformed records are caught here:
+// eight ranks of eight squares, a side to move and one king per side.
+static int is_valid_position(const char* placement, const char* side) {
+    int rank = 0, file = 0, kings[2] = {0, 0};
+
+    for (const char* c = placement; *c; c++) {
+        if (*c == '/') {
+            if (file != 8) return 0;
+            rank++;
+            file = 0;
+        } else if (*c >= '1' && *c <= '8') {
+            file += *c - '0';
+        } else if (strchr("PNBRQKpnbrqk", *c)) {
+            if (*c == 'K') kings[0]++;
+            if (*c == 'k') kings[1]++;
+            file++;
+        } else {
+            return 0;
+        }
+        if (file > 8) return 0;
+    }
+    return rank == 7 && file == 8 && kings[0] == 1 && kings[1] == 1
+        && (strcmp(side, "w") == 0 || strcmp(side, "b") == 0);
+}
+
+static int is_number(const char* token) {
+    if (!*token) return 0;
+    for (; *token; token++) {
+        if (!isdigit((unsigned char)*token)) return 0;
+    }
+    return 1;
+}
+
+// The opcodes analyze_line() writes itself; any other operation of the
+// input (id, am, c0...) is copied to the result so that pipelines can match
+// results to their inputs
+static int is_result_opcode(const char* opcode, size_t length) {
+    static const char* result_opcodes[] = { "bm", "ce", "dm", "acd", "acn", "pv" };
+    for (size_t i = 0; i < sizeof(result_opcodes) / sizeof(result_opcodes[0]); i++) {
+        if (strlen(result_opcodes[i]) == length && strncmp(opcode, result_opcodes[i], length) == 0) return 1;
+    }
+    return 0;
+}
+
+// Copies the kept operations of 'operations' into 'out', each as " op;".
+// Semicolons inside quoted operands don't end an operation.
+static void copy_operations(const char* operations, char* out, size_t size) {
+    size_t written = 0;
+    out[0] = '\0';
+    const char* op = operations;
+    while (*op) {
+        op += strspn(op, " \t\r\n;");
+        if (!*op) break;
+        const char* end = op;
+        int quoted = 0;
+        while (*end && *end != '\r' && *end != '\n' && (quoted || *end != ';')) {
+            if (*end == '"') quoted = !quoted;
+            end++;
+        }
+        size_t length = end - op;
+        while (length > 0 && (op[length - 1] == ' ' || op[length - 1] == '\t')) length--;
+
+        if (!is_result_opcode(op, strcspn(op, " \t;")) && written + length + 3 < size) {
+            written += snprintf(out + written, size - written, " %.*s;", (int)length, op);
+        }
+        if (!*end || *end == '\r' || *end == '\n') break;
+        op = end + 1;
+    }
+}
+
+// EPD score operations: "ce <cp>;", or for a forced mate a ce of 32767
+// minus the plies to mate (negated when the side to move gets mated) so
+// scores stay ordered, plus "dm <moves>;" when the side to move mates
+static void format_epd_score(int score, char* out, size_t size) {
+    if (score > MATE_SCORE - MAX_PLY) {
+        snprintf(out, size, "ce %d; dm %d;", 32767 - (MATE_SCORE - score), (MATE_SCORE - score + 1) / 2);
+    } else if (score < -MATE_SCORE + MAX_PLY) {
+        snprintf(out, size, "ce %d;", -32767 + (MATE_SCORE + score));
+    } else {
+        snprintf(out, size, "ce %d;", score);
+    }
+}
+
+// Searches the position of one FEN/EPD line and returns its EPD result
+// line (malloc'd, newline included).
+static char* analyze_line(SearchContext* ctx, const BatchOptions* options, const char* line, long* nodes) {
+    char* result = malloc(BATCH_RESULT_LENGTH);
+    if (result == NULL) return NULL;
+    *nodes = 0;
+
+    // The first four fields describe the position; FEN adds two counters,
+    // EPD adds operations
+    char copy[BATCH_LINE_LENGTH];
+    char* fields[6] = {0};
+    int field_count = 0;
+    strncpy(copy, line, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+    char* save_ptr;
+    for (char* token = strtok_r(copy, " \t\r\n", &save_ptr); token && field_count < 6; token = strtok_r(NULL, " \t\r\n", &save_ptr)) {
+        fields[field_count++] = token;
+    }
+
+    if (field_count < 4 || !is_valid_position(fields[0], fields[1])) {
+        snprintf(result, BATCH_RESULT_LENGTH, "%.*s c0 \"invalid position\";\n",
+                 (int)strcspn(line, "\r\n"), line);
+        return result;
+    }
+
+    char fen[BATCH_LINE_LENGTH];
+    int has_counters = field_count == 6 && is_number(fields[4]) && is_number(fields[5]);
+    snprintf(fen, sizeof(fen), "%s %s %s %s %s %s", fields[0], fields[1], fields[2], fields[3],
+             has_counters ? fields[4] : "0", has_counters ? fields[5] : "1");
+
+    // Operations start after the last position field (offsets in 'copy' and
+    // 'line' are the same)
+    const char* last_field = fields[has_counters ? 5 : 3];
+    char operations[BATCH_LINE_LENGTH];
+    copy_operations(line + (last_field - copy) + strlen(last_field), operations, sizeof(operations));
+
+    Board board;
+    parse_fen(&board, fen);
+
+    SearchLimits limits = { .depth = options->depth, .nodes = options->nodes };
+    Move best_move = search_with_context(ctx, &board, &limits);
+    const SearchStats* stats = get_context_stats(ctx);
+    *nodes = stats->nodes;
+
+    RootLine line_result;
+    char pv[BATCH_RESULT_LENGTH / 2];
+    if (best_move.from == best_move.to || get_context_root_lines(ctx, &line_result, 1) == 0) {
+        // Checkmate, stalemate or a budget too small for one iteration
+        snprintf(result, BATCH_RESULT_LENGTH, "%s %s %s %s%s acd 0; acn %ld;\n",
+                 fields[0], fields[1], fields[2], fields[3], operations, stats->nodes);
+        return result;
+    }
+
+    char san_move[16];
+    move_to_san(san_move, &board, best_move);
+    get_context_pv(ctx, &board, pv, sizeof(pv));
+    char score[48];
+    format_epd_score(line_result.score, score, sizeof(score));
+    snprintf(result, BATCH_RESULT_LENGTH, "%s %s %s %s%s bm %s; %s acd %d; acn %ld; pv %s;\n",
+             fields[0], fields[1], fields[2], fields[3], operations, san_move, score,
+             stats->depth, stats->nodes, pv);
+    return result;
+}
+
+// Reads the next line worth searching. Called with the lock held.
+static int read_next_line(BatchState* state, char* line) {
+    while (fgets(line, BATCH_LINE_LENGTH, state->input)) {
+        // Drop the rest of an overlong line; the record is cut at the buffer
+        if (!strchr(line, '\n')) {
+            int c;
+            while ((c = fgetc(state->input)) != EOF && c != '\n') {}
+        }
+        const char* start = line + strspn(line, " \t\r\n");
+        if (*start && *start != '#') return 1;
+    }
+    return 0;
+}
+
+static void* batch_worker(void* arg) {
+    BatchState* state = arg;
+    const BatchOptions* options = state->options;
+
+    int hash_mb = options->hash_mb / options->threads;
+    SearchContext* ctx = create_search_context(hash_mb > 0 ? hash_mb : 1);
+    if (ctx == NULL) return NULL;
+    set_search_output(ctx, NULL);
+
+    char line[BATCH_LINE_LENGTH];
+    while (1) {
+        pthread_mutex_lock(&state->lock);
+        // Don't run too far ahead of a position that is still being searched
+        while (!state->input_done && state->next_index >= state->next_to_write + state->window) {
+            pthread_cond_wait(&state->slot_free, &state->lock);
+        }
+        if (state->input_done || !read_next_line(state, line)) {
+            state->input_done = 1;
+            pthread_cond_broadcast(&state->slot_free);
+            pthread_mutex_unlock(&state->lock);
+            break;
+        }
+        long index = state->next_index++;
+        pthread_mutex_unlock(&state->lock);
+
+        long nodes;
+        char* result = analyze_line(ctx, options, line, &nodes);
+
+        pthread_mutex_lock(&state->lock);
+        state->results[index % state->window] = result ? result : strdup("c0 \"out of memory\";\n");
+        state->positions++;
+        state->total_nodes += nodes;
+        if (result && strstr(result, "invalid position")) state->invalid++;
+
+        // Write out every result that is now next in line
+        char** slot;
+        while (*(slot = &state->results[state->next_to_write % state->window]) != NULL) {
+            fputs(*slot, state->output);
+            free(*slot);
+            *slot = NULL;
+            state->next_to_write++;
+        }
+        pthread_cond_broadcast(&state->slot_free);
+        pthread_mutex_unlock(&state->lock);
+    }
+
+    destroy_search_context(ctx);
+    return NULL;
+}
+
+int run_batch(const BatchOptions* options) {
+    BatchOptions opts = *options;
+    if (opts.threads < 1) opts.threads = 1;
+    if (opts.hash_mb < 1) opts.hash_mb = DEFAULT_HASH_MB;
+    if (opts.depth <= 0 && opts.nodes <= 0) opts.depth = 8;
+
+    BatchState state = { .options = &opts };
+    state.input = fopen(opts.input_path, "r");
+    if (state.input == NULL) {
+        fprintf(stderr, "batch: can't open %s\n", opts.input_path);
+        return -1;
+    }
+    state.output = fopen(opts.output_path, "w");
+    if (state.output == NULL) {
+        fprintf(stderr, "batch: can't create %s\n", opts.output_path);
+        fclose(state.input);
+        return -1;
+    }
+    state.window = opts.threads * BATCH_WINDOW_PER_THREAD;
+    state.results = calloc(state.window, sizeof(char*));
+    if (state.results == NULL) {
+        fclose(state.input);
+        fclose(state.output);
+        return -1;
+    }
+    pthread_mutex_init(&state.lock, NULL);
+    pthread_cond_init(&state.slot_free, NULL);
+
+    init_engine();
+    long long start = get_time_ms();
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, BATCH_STACK_SIZE);
+    pthread_t* workers = malloc(opts.threads * sizeof(pthread_t));
+    int started = 0;
+    for (int i = 0; workers && i < opts.threads; i++) {
+        if (pthread_create(&workers[i], &attr, batch_worker, &state) == 0) started++;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    pthread_attr_destroy(&attr);
+
+    long long elapsed = get_time_ms() - start;
+    printf("batch: %ld positions (%ld invalid) in %lld ms, %.1f positions/s, %ld nodes, %lld nps, %d threads\n",
+           state.positions, state.invalid, elapsed, state.positions * 1000.0 / (elapsed + 1),
+           state.total_nodes, state.total_nodes * 1000 / (elapsed + 1), started);
+
+    free(workers);
+    free(state.results);
+    pthread_mutex_destroy(&state.lock);
+    pthread_cond_destroy(&state.slot_free);
+    fclose(state.input);
+    fclose(state.output);
+    return started > 0 ? 0 : -1;
+}
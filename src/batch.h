@@ -0,0 +1,23 @@
+// src/batch.h
+
+#ifndef BATCH_H
+#define BATCH_H
+
+// Offline analysis of a file of positions, one FEN or EPD record per line.
+// Results are written in input order as EPD records with the standard
+// opcodes bm (best move), ce (score in cp), dm (mate in n, when found),
+// acd (depth), acn (nodes) and pv, whatever order the workers finish in. Other operations of the input
+// record, such as id, are copied through ahead of them.
+typedef struct {
+    const char* input_path;
+    const char* output_path;
+    int depth;      // Search depth per position (0 = use 'nodes' only)
+    long nodes;     // Node budget per position (0 = none)
+    int threads;    // Worker threads, each with its own board and TT
+    int hash_mb;    // Total TT memory, split evenly between the workers
+} BatchOptions;
+
+// Returns 0 on success, -1 if a file can't be opened or memory runs out.
+int run_batch(const BatchOptions* options);
+
+#endif // BATCH_H
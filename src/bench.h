@@ -0,0 +1,17 @@
+// src/bench.h
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#define BENCH_DEFAULT_DEPTH 10
+#define BENCH_DEFAULT_HASH_MB 16
+#define BENCH_MAX_THREADS 256
+
+// Searches a fixed set of positions to 'depth', each from a cleared TT and
+// cleared move ordering tables, spread over 'threads' workers with 'hash_mb'
+// of TT each. Prints total nodes, time and NPS. The node total depends only
+// on depth and hash size, so it is the engine's functional signature: a pure
+// speedup must leave it unchanged. Returns 0 on success.
+int run_bench(int depth, int threads, int hash_mb);
+
+#endif // BENCH_H
@@ -2,11 +2,13 @@
 
 #include <stdlib.h> // For abs()
 #include <string.h> // For strtok, strcpy, etc.
-#include <ctype.h>  // For toupper()
+#include <ctype.h>  // For toupper(), tolower()
 
 #include "board.h"
 #include "movegen.h"
 #include "transpose.h"
+#include "evaluate.h"
+#include "nnue.h"
 
 // This array is used to efficiently update castling rights during make_move.
 const int castling_rights_update[64] = {
@@ -41,6 +43,9 @@ static void move_piece(Board* board, int from, int to, int piece) {
 
     board->hash_key ^= piece_keys[piece][from];
     board->hash_key ^= piece_keys[piece][to];
+
+    board->psqt_mg += piece_square_values[piece][to].mg - piece_square_values[piece][from].mg;
+    board->psqt_eg += piece_square_values[piece][to].eg - piece_square_values[piece][from].eg;
 }
 
 static void add_piece(Board* board, int square, int piece) {
@@ -51,6 +56,10 @@ static void add_piece(Board* board, int square, int piece) {
     board->occupancies[side] |= sq_bb;
     board->occupancies[BOTH] |= sq_bb;
     board->hash_key ^= piece_keys[piece][square];
+
+    board->psqt_mg += piece_square_values[piece][square].mg;
+    board->psqt_eg += piece_square_values[piece][square].eg;
+    board->game_phase += piece_phase[piece];
 }
 
 static void remove_piece(Board* board, int square, int piece) {
@@ -61,6 +70,27 @@ static void remove_piece(Board* board, int square, int piece) {
     board->occupancies[side] &= ~sq_bb;
     board->occupancies[BOTH] &= ~sq_bb;
     board->hash_key ^= piece_keys[piece][square];
+
+    board->psqt_mg -= piece_square_values[piece][square].mg;
+    board->psqt_eg -= piece_square_values[piece][square].eg;
+    board->game_phase -= piece_phase[piece];
+}
+
+// Material + piece-square sums and phase from scratch, for a new position
+static void refresh_psqt(Board* board) {
+    board->psqt_mg = 0;
+    board->psqt_eg = 0;
+    board->game_phase = 0;
+    for (int piece = P; piece <= k; piece++) {
+        u64 bitboard = board->piece_bitboards[piece];
+        while (bitboard) {
+            int square = __builtin_ctzll(bitboard);
+            board->psqt_mg += piece_square_values[piece][square].mg;
+            board->psqt_eg += piece_square_values[piece][square].eg;
+            board->game_phase += piece_phase[piece];
+            bitboard &= bitboard - 1;
+        }
+    }
 }
 
 // --- Main Functions ---
@@ -69,7 +99,18 @@ void make_move(Board* board, Move move) {
     board->history[board->ply].hash_key = board->hash_key;
     board->history[board->ply].castling_rights = board->castling_rights;
     board->history[board->ply].enpassant_square = board->enpassant_square;
+    board->history[board->ply].halfmove_clock = board->halfmove_clock;
     board->history[board->ply].captured_piece = -1;
+    board->history[board->ply].psqt_mg = board->psqt_mg;
+    board->history[board->ply].psqt_eg = board->psqt_eg;
+    board->history[board->ply].game_phase = board->game_phase;
+
+    // Captures and pawn moves are irreversible and reset the fifty-move count
+    if (move.is_capture || move.piece == P || move.piece == p) {
+        board->halfmove_clock = 0;
+    } else {
+        board->halfmove_clock++;
+    }
 
     // Update hash key for castling and en passant before they change
     board->hash_key ^= castle_keys[board->castling_rights];
@@ -131,6 +172,9 @@ void make_move(Board* board, Move move) {
     board->side_to_move = !board->side_to_move;
     board->hash_key ^= side_key;
     board->ply++;
+
+    // The accumulator of the previous ply stays valid for unmake_move()
+    if (board->nnue) nnue_make_move(board, move);
 }
 
 void unmake_move(Board* board, Move move) {
@@ -138,9 +182,9 @@ void unmake_move(Board* board, Move move) {
     UndoInfo undo = board->history[board->ply];
 
     board->side_to_move = !board->side_to_move;
-    board->hash_key = undo.hash_key;
     board->castling_rights = undo.castling_rights;
     board->enpassant_square = undo.enpassant_square;
+    board->halfmove_clock = undo.halfmove_clock;
 
     int piece_that_moved = move.promotion ? move.promotion : move.piece;
     move_piece(board, move.to, move.from, piece_that_moved);
@@ -166,9 +210,70 @@ void unmake_move(Board* board, Move move) {
         }
         add_piece(board, captured_sq, undo.captured_piece);
     }
+
+    // The piece helpers above also update the hash key and the evaluation
+    // sums, so restore them last
+    board->hash_key = undo.hash_key;
+    board->psqt_mg = undo.psqt_mg;
+    board->psqt_eg = undo.psqt_eg;
+    board->game_phase = undo.game_phase;
+}
+
+// Passes the turn without moving. The history slot is filled like a real
+// move, and the fifty-move count restarts so repetition checks stop here:
+// positions on the other side of a null move are not real repetitions.
+void make_null_move(Board* board) {
+    board->history[board->ply].hash_key = board->hash_key;
+    board->history[board->ply].castling_rights = board->castling_rights;
+    board->history[board->ply].enpassant_square = board->enpassant_square;
+    board->history[board->ply].halfmove_clock = board->halfmove_clock;
+    board->history[board->ply].captured_piece = -1;
+
+    if (board->enpassant_square != -1) {
+        board->hash_key ^= enpassant_keys[board->enpassant_square];
+    }
+    board->enpassant_square = -1;
+    board->halfmove_clock = 0;
+    board->side_to_move = !board->side_to_move;
+    board->hash_key ^= side_key;
+    board->ply++;
+
+    if (board->nnue) nnue_make_null_move(board);
+}
+
+void unmake_null_move(Board* board) {
+    board->ply--;
+    UndoInfo undo = board->history[board->ply];
+
+    board->side_to_move = !board->side_to_move;
+    board->hash_key = undo.hash_key;
+    board->enpassant_square = undo.enpassant_square;
+    board->halfmove_clock = undo.halfmove_clock;
+}
+
+// Returns 1 if the current position should be scored as a draw by
+// repetition. Any repeat of a position reached after 'root_ply' (i.e. inside
+// the search) counts, while positions from the game before the root need to
+// have occurred twice already (threefold repetition).
+int is_repetition(const Board* board, int root_ply) {
+    int count = 0;
+    int oldest = board->ply - board->halfmove_clock;
+    if (oldest < 0) oldest = 0;
+
+    // Only positions with the same side to move can match
+    for (int i = board->ply - 2; i >= oldest; i -= 2) {
+        if (board->history[i].hash_key == board->hash_key) {
+            if (i >= root_ply) return 1;
+            if (++count == 2) return 1;
+        }
+    }
+    return 0;
+}
+
+int is_fifty_move_draw(const Board* board) {
+    return board->halfmove_clock >= 100;
 }
 
-// ... (parse_fen and move_to_san remain the same)
 void parse_fen(Board* board, const char* fen) {
     memset(board->piece_bitboards, 0, sizeof(board->piece_bitboards));
     memset(board->occupancies, 0, sizeof(board->occupancies));
@@ -177,12 +282,15 @@ void parse_fen(Board* board, const char* fen) {
     board->enpassant_square = -1;
     board->castling_rights = 0;
     board->ply = 0;
+    board->halfmove_clock = 0;
     
     char fen_copy[256];
     strncpy(fen_copy, fen, 255);
     fen_copy[255] = '\0';
 
-    char* token = strtok(fen_copy, " ");
+    // strtok_r: positions may be parsed on several threads at once
+    char* save_ptr;
+    char* token = strtok_r(fen_copy, " ", &save_ptr);
     int rank = 7, file = 0;
 
     for (size_t i = 0; i < strlen(token); i++) {
@@ -213,10 +321,10 @@ void parse_fen(Board* board, const char* fen) {
         }
     }
 
-    token = strtok(NULL, " ");
+    token = strtok_r(NULL, " ", &save_ptr);
     board->side_to_move = (strcmp(token, "w") == 0) ? WHITE : BLACK;
 
-    token = strtok(NULL, " ");
+    token = strtok_r(NULL, " ", &save_ptr);
     for (size_t i = 0; i < strlen(token); i++) {
         switch (token[i]) {
             case 'K': board->castling_rights |= WK; break;
@@ -226,16 +334,65 @@ void parse_fen(Board* board, const char* fen) {
         }
     }
 
-    token = strtok(NULL, " ");
+    token = strtok_r(NULL, " ", &save_ptr);
     if (strcmp(token, "-") != 0) {
         board->enpassant_square = (token[0] - 'a') + (token[1] - '1') * 8;
     }
 
+    // Halfmove clock (the fullmove number after it is not needed)
+    token = strtok_r(NULL, " ", &save_ptr);
+    if (token != NULL) {
+        board->halfmove_clock = atoi(token);
+    }
+
     for (int piece = P; piece <= K; piece++) board->occupancies[WHITE] |= board->piece_bitboards[piece];
     for (int piece = p; piece <= k; piece++) board->occupancies[BLACK] |= board->piece_bitboards[piece];
     board->occupancies[BOTH] = board->occupancies[WHITE] | board->occupancies[BLACK];
 
     board->hash_key = generate_hash_key(board);
+    refresh_psqt(board);
+    board->nnue = NULL;
+}
+
+// Finds the move given in coordinate notation (e.g. "e2e4", "e7e8q") among
+// the moves of the current position. Returns 0 if there is no such move.
+int parse_move(Board* board, const char* move_string, Move* move) {
+    if (strlen(move_string) < 4) return 0;
+
+    int from = (move_string[0] - 'a') + (move_string[1] - '1') * 8;
+    int to = (move_string[2] - 'a') + (move_string[3] - '1') * 8;
+    char promotion = move_string[4];
+
+    MoveList move_list;
+    generate_all_moves(board, &move_list);
+    for (int i = 0; i < move_list.count; i++) {
+        Move candidate = move_list.moves[i];
+        if (candidate.from != from || candidate.to != to) continue;
+        if (candidate.promotion && tolower(piece_to_char[candidate.promotion]) != promotion) continue;
+        if (!candidate.promotion && promotion != '\0' && promotion != ' ') continue;
+        *move = candidate;
+        return 1;
+    }
+    return 0;
+}
+
+// Plays a space-separated list of coordinate moves on the board. This also
+// seeds the move history used for repetition detection in the search.
+// Returns the number of moves played, stopping at the first invalid one.
+int parse_game_moves(Board* board, const char* moves) {
+    char moves_copy[4096];
+    strncpy(moves_copy, moves, sizeof(moves_copy) - 1);
+    moves_copy[sizeof(moves_copy) - 1] = '\0';
+
+    int played = 0;
+    char* save_ptr;
+    for (char* token = strtok_r(moves_copy, " \n", &save_ptr); token != NULL; token = strtok_r(NULL, " \n", &save_ptr)) {
+        Move move;
+        if (board->ply >= MAX_GAME_PLY - 256 || !parse_move(board, token, &move)) break;
+        make_move(board, move);
+        played++;
+    }
+    return played;
 }
 
 void move_to_san(char* san_string, Board* board, Move move) {
@@ -291,39 +448,32 @@ void move_to_san(char* san_string, Board* board, Move move) {
     }
 
     // --- Check and Checkmate Detection ---
-    Board board_after_move = *board;
-    make_move(&board_after_move, move);
-    
-    int opponent_side = board_after_move.side_to_move;
+    // Played on the board itself and taken back: a Board carries the whole
+    // move history, too large to copy for every reply. The accumulators
+    // aren't needed, so they're left alone.
+    struct NnueStack* nnue = board->nnue;
+    board->nnue = NULL;
+    make_move(board, move);
+
+    int opponent_side = board->side_to_move;
     int opponent_king_piece = (opponent_side == WHITE) ? K : k;
-    u64 opponent_king_bb = board_after_move.piece_bitboards[opponent_king_piece];
-
-    // Make sure the king is still on the board (wasn't a bugged capture)
-    if (opponent_king_bb == 0) return;
+    u64 opponent_king_bb = board->piece_bitboards[opponent_king_piece];
 
-    int opponent_king_sq = __builtin_ctzll(opponent_king_bb);
-
-    // Is the opponent in check?
-    if (is_square_attacked(opponent_king_sq, !opponent_side, &board_after_move)) {
+    // Is the opponent in check? (The king may be missing after a bugged capture.)
+    if (opponent_king_bb != 0 && is_square_attacked(__builtin_ctzll(opponent_king_bb), !opponent_side, board)) {
         // To check for mate, we see if the opponent has any legal moves.
         MoveList opponent_moves;
-        generate_all_moves(&board_after_move, &opponent_moves);
+        generate_all_moves(board, &opponent_moves);
         int has_legal_move = 0;
 
-        for (int i = 0; i < opponent_moves.count; ++i) {
-            Board board_after_reply = board_after_move;
-            make_move(&board_after_reply, opponent_moves.moves[i]);
-            
-            u64 reply_king_bb = board_after_reply.piece_bitboards[opponent_king_piece];
-            if(reply_king_bb == 0) continue;
-
-            int reply_king_sq = __builtin_ctzll(reply_king_bb);
-            
+        for (int i = 0; i < opponent_moves.count && !has_legal_move; ++i) {
+            make_move(board, opponent_moves.moves[i]);
+            u64 reply_king_bb = board->piece_bitboards[opponent_king_piece];
             // If the king is NOT attacked after the reply, it's a legal move.
-            if (!is_square_attacked(reply_king_sq, !board_after_reply.side_to_move, &board_after_reply)) {
+            if (reply_king_bb != 0 && !is_square_attacked(__builtin_ctzll(reply_king_bb), board->side_to_move, board)) {
                 has_legal_move = 1;
-                break; // Found a legal move, so it's not mate.
             }
+            unmake_move(board, opponent_moves.moves[i]);
         }
 
         if (has_legal_move) {
@@ -332,4 +482,7 @@ void move_to_san(char* san_string, Board* board, Move move) {
             strcat(san_string, "#"); // No legal moves, it's checkmate
         }
     }
+
+    unmake_move(board, move);
+    board->nnue = nnue;
 }
\ No newline at end of file
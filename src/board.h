@@ -10,9 +10,16 @@ typedef struct {
     int captured_piece;
     int enpassant_square;
     int castling_rights;
+    int halfmove_clock;
     u64 hash_key;
+    int psqt_mg;
+    int psqt_eg;
+    int game_phase;
 } UndoInfo;
 
+// Game plies plus search plies the move history can hold
+#define MAX_GAME_PLY 1024
+
 extern const char* square_to_algebraic[];
 
 // Helper array to map piece enum to a character for printing promotions
@@ -25,15 +32,30 @@ typedef struct {
     int side_to_move;
     int enpassant_square;
     int castling_rights;
-    int ply;
+    int ply;            // Moves made since parse_fen(), game and search alike
+    int halfmove_clock; // Plies since the last capture or pawn move (fifty-move rule)
     u64 hash_key;
-    UndoInfo history[256];
+    // Kept up to date by make/unmake for evaluate(): material + piece-square
+    // sums from White's point of view, and the phase weight of the pieces
+    int psqt_mg;
+    int psqt_eg;
+    int game_phase;
+    struct NnueStack* nnue; // NNUE accumulators make_move() keeps up to date, or NULL (see nnue.h)
+    UndoInfo history[MAX_GAME_PLY]; // history[i].hash_key is the position at ply i
 } Board;
 
 // --- Function Prototypes ---
 void make_move(Board* board, Move move);
 void unmake_move(Board* board, Move move);
+void make_null_move(Board* board);
+void unmake_null_move(Board* board);
 void parse_fen(Board* board, const char* fen);
+int parse_move(Board* board, const char* move_string, Move* move);
+int parse_game_moves(Board* board, const char* moves);
+
+// Draw detection using the game/search move history
+int is_repetition(const Board* board, int root_ply);
+int is_fifty_move_draw(const Board* board);
 
 void move_to_san(char* san_string, Board* board, Move move);
 
@@ -4,6 +4,8 @@
 #include <stdint.h>
 
 // More convenient typedefs
+typedef uint8_t u8;
+typedef uint16_t u16;
 typedef uint32_t u32;
 typedef uint64_t u64;
 typedef int16_t i16;
@@ -4,6 +4,8 @@
 #include "defs.h"
 #include "bitboard.h"
 #include "movegen.h"
+#include "nnue.h"
+#include "mobility.h"
 
 /*
 ================================================================================
@@ -37,6 +39,9 @@ const Score queen_mobility[28] = {
     {159,185},{168,194},{176,203},{185,211},{194,219},{202,226},{210,233},{218,240},{225,246},{232,252},{239,258},{246,264},{252,269}
 };
 
+// Indexed like Mobility: knights, bishops, rooks, queens
+static const Score* mobility_tables[4] = { knight_mobility, bishop_mobility, rook_mobility, queen_mobility };
+
 // --- Piece-Square Tables (PSTs) ---
 // These tables give a score to each piece based on its position on the board.
 // Scores are from White's perspective. Black's scores are the mirror image.
@@ -115,7 +120,15 @@ const Score* psts[12] = {
     pawn_pst, knight_pst, bishop_pst, rook_pst, queen_pst, king_pst
 };
 
-const int game_phase_inc[] = {0, 1, 1, 2, 4, 0};
+// --- Pawn Structure ---
+const Score passed_pawn_bonus = { 10, 20 };
+const Score doubled_pawn_penalty = { -10, -10 };
+const Score isolated_pawn_penalty = { -10, -10 };
+
+const int piece_phase[12] = {0, 1, 1, 2, 4, 0, 0, 1, 1, 2, 4, 0};
+
+// Filled in by init_evaluation_masks()
+Score piece_square_values[12][64];
 
 // These help us quickly identify passed, isolated, and doubled pawns.
 u64 file_masks[8];
@@ -123,7 +136,20 @@ u64 adjacent_file_masks[8];
 u64 passed_pawn_masks[2][64]; // [color][square]
 
 
+static void init_piece_square_values() {
+    for (int piece = P; piece <= K; piece++) {
+        for (int sq = 0; sq < 64; sq++) {
+            piece_square_values[piece][sq].mg = material_score[piece].mg + psts[piece][sq].mg;
+            piece_square_values[piece][sq].eg = material_score[piece].eg + psts[piece][sq].eg;
+            piece_square_values[piece + 6][sq].mg = -(material_score[piece + 6].mg + psts[piece + 6][S(sq)].mg);
+            piece_square_values[piece + 6][sq].eg = -(material_score[piece + 6].eg + psts[piece + 6][S(sq)].eg);
+        }
+    }
+}
+
 void init_evaluation_masks() {
+    init_piece_square_values();
+
     for (int f = 0; f < 8; ++f) {
         file_masks[f] = 0x0101010101010101ULL << f;
         adjacent_file_masks[f] = 0;
@@ -147,44 +173,56 @@ void init_evaluation_masks() {
     }
 }
 
+// Blends the middlegame and endgame scores by game phase, for the side to move
+static int tapered_score(const Board* board, int mg_score, int eg_score, int game_phase) {
+    if (game_phase > 24) game_phase = 24;
+    int final_score = (mg_score * game_phase + eg_score * (24 - game_phase)) / 24;
+    return (board->side_to_move == WHITE) ? final_score : -final_score;
+}
+
 int evaluate(Board* board) {
-    int mg_score = 0;
-    int eg_score = 0;
-    int game_phase = 0;
+    // Searches attach accumulators only while a network is enabled
+    if (board->nnue) return nnue_evaluate(board);
+
     u64 bitboard;
     int square;
 
-    // --- Material and PST Evaluation (Unchanged) ---
-    for (int piece = P; piece <= k; ++piece) {
-        bitboard = board->piece_bitboards[piece];
-        int piece_type = (piece < 6) ? piece : piece - 6;
-        game_phase += popcount(bitboard) * game_phase_inc[piece_type];
-
-        while (bitboard) {
-            square = __builtin_ctzll(bitboard);
-            if (piece < 6) { // White
-                mg_score += material_score[piece].mg + psts[piece][square].mg;
-                eg_score += material_score[piece].eg + psts[piece][square].eg;
-            } else { // Black
-                mg_score -= material_score[piece].mg + psts[piece][S(square)].mg;
-                eg_score -= material_score[piece].eg + psts[piece][S(square)].eg;
+    // --- Material and PST Evaluation ---
+    // Maintained incrementally by make_move()/unmake_move()
+    int mg_score = board->psqt_mg;
+    int eg_score = board->psqt_eg;
+    int game_phase = board->game_phase;
+
+    // --- Mobility ---
+    // The default magic lookups are done inline; the set-wise kernel, when
+    // selected, goes through a Mobility buffer instead
+    if (mobility_kernel == MOBILITY_MAGIC) {
+        u64 all_pieces = board->occupancies[BOTH];
+        // White Mobility
+        bitboard = board->piece_bitboards[N]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(knight_attacks[square] & ~board->occupancies[WHITE]); mg_score += knight_mobility[moves].mg; eg_score += knight_mobility[moves].eg; bitboard &= bitboard-1; }
+        bitboard = board->piece_bitboards[B]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(bishopAttacks(all_pieces, square) & ~board->occupancies[WHITE]); mg_score += bishop_mobility[moves].mg; eg_score += bishop_mobility[moves].eg; bitboard &= bitboard-1; }
+        bitboard = board->piece_bitboards[R]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(rookAttacks(all_pieces, square) & ~board->occupancies[WHITE]); mg_score += rook_mobility[moves].mg; eg_score += rook_mobility[moves].eg; bitboard &= bitboard-1; }
+        bitboard = board->piece_bitboards[Q]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount((bishopAttacks(all_pieces, square) | rookAttacks(all_pieces, square)) & ~board->occupancies[WHITE]); mg_score += queen_mobility[moves].mg; eg_score += queen_mobility[moves].eg; bitboard &= bitboard-1; }
+        // Black Mobility
+        bitboard = board->piece_bitboards[n]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(knight_attacks[square] & ~board->occupancies[BLACK]); mg_score -= knight_mobility[moves].mg; eg_score -= knight_mobility[moves].eg; bitboard &= bitboard-1; }
+        bitboard = board->piece_bitboards[b]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(bishopAttacks(all_pieces, square) & ~board->occupancies[BLACK]); mg_score -= bishop_mobility[moves].mg; eg_score -= bishop_mobility[moves].eg; bitboard &= bitboard-1; }
+        bitboard = board->piece_bitboards[r]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(rookAttacks(all_pieces, square) & ~board->occupancies[BLACK]); mg_score -= rook_mobility[moves].mg; eg_score -= rook_mobility[moves].eg; bitboard &= bitboard-1; }
+        bitboard = board->piece_bitboards[q]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount((bishopAttacks(all_pieces, square) | rookAttacks(all_pieces, square)) & ~board->occupancies[BLACK]); mg_score -= queen_mobility[moves].mg; eg_score -= queen_mobility[moves].eg; bitboard &= bitboard-1; }
+    } else {
+        for (int side = WHITE; side <= BLACK; side++) {
+            Mobility mobility;
+            mobility_setwise(board, side, &mobility);
+            int sign = side == WHITE ? 1 : -1;
+            for (int type = 0; type < 4; type++) {
+                for (int i = 0; i < mobility.count[type]; i++) {
+                    Score bonus = mobility_tables[type][mobility.moves[type][i]];
+                    mg_score += sign * bonus.mg;
+                    eg_score += sign * bonus.eg;
+                }
             }
-            bitboard &= bitboard - 1;
         }
     }
 
-    u64 all_pieces = board->occupancies[BOTH];
-    // White Mobility
-    bitboard = board->piece_bitboards[N]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(knight_attacks[square] & ~board->occupancies[WHITE]); mg_score += knight_mobility[moves].mg; eg_score += knight_mobility[moves].eg; bitboard &= bitboard-1; }
-    bitboard = board->piece_bitboards[B]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(bishopAttacks(all_pieces, square) & ~board->occupancies[WHITE]); mg_score += bishop_mobility[moves].mg; eg_score += bishop_mobility[moves].eg; bitboard &= bitboard-1; }
-    bitboard = board->piece_bitboards[R]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(rookAttacks(all_pieces, square) & ~board->occupancies[WHITE]); mg_score += rook_mobility[moves].mg; eg_score += rook_mobility[moves].eg; bitboard &= bitboard-1; }
-    bitboard = board->piece_bitboards[Q]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount((bishopAttacks(all_pieces, square) | rookAttacks(all_pieces, square)) & ~board->occupancies[WHITE]); mg_score += queen_mobility[moves].mg; eg_score += queen_mobility[moves].eg; bitboard &= bitboard-1; }
-    // Black Mobility
-    bitboard = board->piece_bitboards[n]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(knight_attacks[square] & ~board->occupancies[BLACK]); mg_score -= knight_mobility[moves].mg; eg_score -= knight_mobility[moves].eg; bitboard &= bitboard-1; }
-    bitboard = board->piece_bitboards[b]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(bishopAttacks(all_pieces, square) & ~board->occupancies[BLACK]); mg_score -= bishop_mobility[moves].mg; eg_score -= bishop_mobility[moves].eg; bitboard &= bitboard-1; }
-    bitboard = board->piece_bitboards[r]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount(rookAttacks(all_pieces, square) & ~board->occupancies[BLACK]); mg_score -= rook_mobility[moves].mg; eg_score -= rook_mobility[moves].eg; bitboard &= bitboard-1; }
-    bitboard = board->piece_bitboards[q]; while(bitboard) { square = __builtin_ctzll(bitboard); int moves = popcount((bishopAttacks(all_pieces, square) | rookAttacks(all_pieces, square)) & ~board->occupancies[BLACK]); mg_score -= queen_mobility[moves].mg; eg_score -= queen_mobility[moves].eg; bitboard &= bitboard-1; }
-
     // --- NEW: Pawn Structure Evaluation ---
     // (A simplified version for clarity)
     u64 white_pawns = board->piece_bitboards[P];
@@ -196,15 +234,15 @@ int evaluate(Board* board) {
         int file = square % 8;
         // Passed pawn check
         if ((passed_pawn_masks[WHITE][square] & black_pawns) == 0) {
-            mg_score += 10; eg_score += 20; // Bonus for passed pawn
+            mg_score += passed_pawn_bonus.mg; eg_score += passed_pawn_bonus.eg;
         }
         // Doubled pawn check
         if (popcount(white_pawns & file_masks[file]) > 1) {
-            mg_score -= 10; eg_score -= 10; // Penalty for doubled pawn
+            mg_score += doubled_pawn_penalty.mg; eg_score += doubled_pawn_penalty.eg;
         }
         // Isolated pawn check
         if ((adjacent_file_masks[file] & white_pawns) == 0) {
-            mg_score -= 10; eg_score -= 10; // Penalty for isolated pawn
+            mg_score += isolated_pawn_penalty.mg; eg_score += isolated_pawn_penalty.eg;
         }
         bitboard &= bitboard - 1;
     }
@@ -215,15 +253,24 @@ int evaluate(Board* board) {
         square = __builtin_ctzll(bitboard);
         int file = square % 8;
 
-        if ((passed_pawn_masks[BLACK][square] & white_pawns) == 0) { mg_score -= 10; eg_score -= 20; }
-        if (popcount(black_pawns & file_masks[file]) > 1) { mg_score += 10; eg_score += 10; }
-        if ((adjacent_file_masks[file] & white_pawns) == 0) { mg_score += 10; eg_score += 10; }
+        if ((passed_pawn_masks[BLACK][square] & white_pawns) == 0) { mg_score -= passed_pawn_bonus.mg; eg_score -= passed_pawn_bonus.eg; }
+        if (popcount(black_pawns & file_masks[file]) > 1) { mg_score -= doubled_pawn_penalty.mg; eg_score -= doubled_pawn_penalty.eg; }
+        if ((adjacent_file_masks[file] & black_pawns) == 0) { mg_score -= isolated_pawn_penalty.mg; eg_score -= isolated_pawn_penalty.eg; }
 
         bitboard &= bitboard - 1;
     }
 
-    // --- Final Tapered Score Calculation ---
-    if (game_phase > 24) game_phase = 24;
-    int final_score = (mg_score * game_phase + eg_score * (24 - game_phase)) / 24;
-    return (board->side_to_move == WHITE) ? final_score : -final_score;
+    return tapered_score(board, mg_score, eg_score, game_phase);
+}
+
+int evaluate_lazy(Board* board, int alpha, int beta, int* early_exit) {
+    if (early_exit) *early_exit = 0;
+    if (board->nnue) return nnue_evaluate(board);
+
+    int estimate = tapered_score(board, board->psqt_mg, board->psqt_eg, board->game_phase);
+    if (estimate - LAZY_EVAL_MARGIN >= beta || estimate + LAZY_EVAL_MARGIN <= alpha) {
+        if (early_exit) *early_exit = 1;
+        return estimate;
+    }
+    return evaluate(board);
 }
\ No newline at end of file
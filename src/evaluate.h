@@ -10,9 +10,41 @@ typedef struct {
     int eg;
 } Score;
 
+// Material values per piece, also used by the search for delta pruning.
+extern const Score material_score[12];
+
+// The hand-written weights, also read by the tuner (tools/tune.c), which
+// prints replacements for them in the same layout
+extern const Score knight_mobility[9];
+extern const Score bishop_mobility[14];
+extern const Score rook_mobility[15];
+extern const Score queen_mobility[28];
+extern const Score* psts[12];
+extern const Score passed_pawn_bonus;
+extern const Score doubled_pawn_penalty;
+extern const Score isolated_pawn_penalty;
+extern u64 file_masks[8];
+extern u64 adjacent_file_masks[8];
+extern u64 passed_pawn_masks[2][64];
+
+// Material + PST per [piece][square], signed from White's point of view with
+// Black's squares already mirrored, and the phase weight of each piece.
+// The board keeps running sums of both in make/unmake.
+extern Score piece_square_values[12][64];
+extern const int piece_phase[12];
+
 // The main evaluation function. It returns a score in centipawns
-// from the perspective of the side to move.
+// from the perspective of the side to move, from the NNUE network if the
+// board has accumulators attached (see nnue.h).
 int evaluate(Board* board);
+
+// Mobility and pawn structure hardly ever move the score by more than this
+#define LAZY_EVAL_MARGIN 300
+
+// Like evaluate(), but only when the score may land inside (alpha, beta):
+// if material + PST alone is LAZY_EVAL_MARGIN beyond the window, that
+// estimate is returned and *early_exit (if not NULL) is set.
+int evaluate_lazy(Board* board, int alpha, int beta, int* early_exit);
 void init_evaluation_masks();
 
 #endif // EVALUATE_H
\ No newline at end of file
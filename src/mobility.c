@@ -0,0 +1,246 @@
+// src/mobility.c
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MOBILITY_X86
+#endif
+
+#include "mobility.h"
+#include "bitboard.h"
+#include "movegen.h"
+
+// --- Magic Lookups ---
+
+void mobility_magic(const Board* board, int side, Mobility* out) {
+    int offset = side == WHITE ? 0 : 6;
+    u64 own = board->occupancies[side];
+    u64 occupancy = board->occupancies[BOTH];
+
+    for (int type = 0; type < 4; type++) {
+        u64 bitboard = board->piece_bitboards[N + offset + type];
+        int count = 0;
+        while (bitboard && count < MOBILITY_MAX_PIECES) {
+            int square = __builtin_ctzll(bitboard);
+            u64 attacks = type == 0 ? knight_attacks[square]
+                        : type == 1 ? bishopAttacks(occupancy, square)
+                        : type == 2 ? rookAttacks(occupancy, square)
+                        : bishopAttacks(occupancy, square) | rookAttacks(occupancy, square);
+            out->moves[type][count++] = popcount(attacks & ~own);
+            bitboard &= bitboard - 1;
+        }
+        out->count[type] = count;
+    }
+}
+
+// --- Set-wise Fills ---
+// Each piece is a one-bit bitboard in its own lane. A Kogge-Stone fill
+// floods a ray in log2(7) = 3 shift steps, stopping at the first occupied
+// square; shifting once more gives the attacks, blocker included. The wrap
+// masks stop east/west moves from crossing the board edge.
+
+#define NOT_A_FILE  0xfefefefefefefefeULL
+#define NOT_H_FILE  0x7f7f7f7f7f7f7f7fULL
+#define NOT_AB_FILE 0xfcfcfcfcfcfcfcfcULL
+#define NOT_GH_FILE 0x3f3f3f3f3f3f3f3fULL
+#define ALL_SQUARES 0xffffffffffffffffULL
+
+typedef struct {
+    int shift;  // Positive: towards h8 (<<), negative: towards a1 (>>)
+    u64 wrap;   // Squares a step in this direction can land on
+} Direction;
+
+static const Direction orthogonal[4] = { { 1, NOT_A_FILE }, { -1, NOT_H_FILE }, { 8, ALL_SQUARES }, { -8, ALL_SQUARES } };
+static const Direction diagonal[4] = { { 9, NOT_A_FILE }, { 7, NOT_H_FILE }, { -7, NOT_A_FILE }, { -9, NOT_H_FILE } };
+static const Direction knight_jumps[8] = {
+    { 17, NOT_A_FILE }, { 15, NOT_H_FILE }, { 10, NOT_AB_FILE }, { 6, NOT_GH_FILE },
+    { -17, NOT_H_FILE }, { -15, NOT_A_FILE }, { -10, NOT_GH_FILE }, { -6, NOT_AB_FILE },
+};
+
+static inline u64 shift_bb(u64 bb, int shift) {
+    return shift > 0 ? bb << shift : bb >> -shift;
+}
+
+static u64 slide_scalar(u64 piece, u64 empty, const Direction* directions) {
+    u64 attacks = 0;
+    for (int d = 0; d < 4; d++) {
+        int s = directions[d].shift;
+        u64 wrap = directions[d].wrap;
+        u64 gen = piece, pro = empty & wrap;
+        gen |= pro & shift_bb(gen, s);
+        pro &= shift_bb(pro, s);
+        gen |= pro & shift_bb(gen, 2 * s);
+        pro &= shift_bb(pro, 2 * s);
+        gen |= pro & shift_bb(gen, 4 * s);
+        attacks |= shift_bb(gen, s) & wrap;
+    }
+    return attacks;
+}
+
+static u64 jump_scalar(u64 piece) {
+    u64 attacks = 0;
+    for (int j = 0; j < 8; j++) attacks |= shift_bb(piece, knight_jumps[j].shift) & knight_jumps[j].wrap;
+    return attacks;
+}
+
+static void collect_pieces(const Board* board, int side, u64 pieces[4][MOBILITY_MAX_PIECES], Mobility* out) {
+    int offset = side == WHITE ? 0 : 6;
+    for (int type = 0; type < 4; type++) {
+        u64 bitboard = board->piece_bitboards[N + offset + type];
+        int count = 0;
+        while (bitboard && count < MOBILITY_MAX_PIECES) {
+            pieces[type][count] = bitboard & -bitboard;
+            out->moves[type][count++] = 0;
+            bitboard &= bitboard - 1;
+        }
+        out->count[type] = count;
+    }
+}
+
+void mobility_setwise_scalar(const Board* board, int side, Mobility* out) {
+    u64 pieces[4][MOBILITY_MAX_PIECES];
+    collect_pieces(board, side, pieces, out);
+    u64 targets = ~board->occupancies[side];
+    u64 empty = ~board->occupancies[BOTH];
+
+    for (int i = 0; i < out->count[0]; i++) out->moves[0][i] = popcount(jump_scalar(pieces[0][i]) & targets);
+    for (int i = 0; i < out->count[1]; i++) out->moves[1][i] = popcount(slide_scalar(pieces[1][i], empty, diagonal) & targets);
+    for (int i = 0; i < out->count[2]; i++) out->moves[2][i] = popcount(slide_scalar(pieces[2][i], empty, orthogonal) & targets);
+    // Queens slide both ways; their orthogonal and diagonal rays are
+    // disjoint, so the two counts simply add up
+    for (int i = 0; i < out->count[3]; i++) {
+        out->moves[3][i] = popcount((slide_scalar(pieces[3][i], empty, orthogonal) | slide_scalar(pieces[3][i], empty, diagonal)) & targets);
+    }
+}
+
+#ifdef MOBILITY_X86
+// Sliders put their four ray directions in the lanes instead: one vector
+// per bishop or rook, two per queen, with per-lane shift counts. A count
+// of 64 clears the lane, so every step does a left and a right variable
+// shift and ORs them. The propagator chain depends only on the board, so
+// it is built once per direction set and shared by all pieces. Knights
+// are few and each has eight jumps, so they still go four to a vector.
+
+typedef struct {
+    u64 left[3][4] __attribute__((aligned(32)));   // 1, 2 and 4 steps towards h8 (64 = none)
+    u64 right[3][4] __attribute__((aligned(32)));  // 1, 2 and 4 steps towards a1 (64 = none)
+    u64 wrap[4] __attribute__((aligned(32)));
+} RayLanes;
+
+static RayLanes diagonal_lanes, orthogonal_lanes;
+
+static void build_ray_lanes(RayLanes* lanes, const Direction* directions) {
+    for (int d = 0; d < 4; d++) {
+        int s = directions[d].shift;
+        for (int step = 0; step < 3; step++) {
+            lanes->left[step][d] = s > 0 ? (u64)(s << step) : 64;
+            lanes->right[step][d] = s < 0 ? (u64)(-s << step) : 64;
+        }
+        lanes->wrap[d] = directions[d].wrap;
+    }
+}
+
+typedef struct {
+    __m256i left[3], right[3];
+    __m256i wrap;
+    __m256i pro[3];  // Empty squares a fill may cross at each step
+} RayFill;
+
+__attribute__((target("avx2")))
+static inline __m256i shift_lanes(__m256i bb, __m256i left, __m256i right) {
+    return _mm256_or_si256(_mm256_sllv_epi64(bb, left), _mm256_srlv_epi64(bb, right));
+}
+
+__attribute__((target("avx2")))
+static inline void prepare_fill(RayFill* fill, const RayLanes* lanes, u64 empty) {
+    for (int step = 0; step < 3; step++) {
+        fill->left[step] = _mm256_load_si256((const __m256i*)lanes->left[step]);
+        fill->right[step] = _mm256_load_si256((const __m256i*)lanes->right[step]);
+    }
+    fill->wrap = _mm256_load_si256((const __m256i*)lanes->wrap);
+    fill->pro[0] = _mm256_and_si256(_mm256_set1_epi64x((long long)empty), fill->wrap);
+    fill->pro[1] = _mm256_and_si256(fill->pro[0], shift_lanes(fill->pro[0], fill->left[0], fill->right[0]));
+    fill->pro[2] = _mm256_and_si256(fill->pro[1], shift_lanes(fill->pro[1], fill->left[1], fill->right[1]));
+}
+
+// Attacks of one slider along the four directions of 'fill'
+__attribute__((target("avx2")))
+static inline u64 slide_avx2(u64 piece, const RayFill* fill) {
+    __m256i gen = _mm256_set1_epi64x((long long)piece);
+    for (int step = 0; step < 3; step++) {
+        gen = _mm256_or_si256(gen, _mm256_and_si256(fill->pro[step], shift_lanes(gen, fill->left[step], fill->right[step])));
+    }
+    __m256i attacks = _mm256_and_si256(shift_lanes(gen, fill->left[0], fill->right[0]), fill->wrap);
+    __m128i half = _mm_or_si128(_mm256_castsi256_si128(attacks), _mm256_extracti128_si256(attacks, 1));
+    return (u64)_mm_cvtsi128_si64(_mm_or_si128(half, _mm_unpackhi_epi64(half, half)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i shift_vector(__m256i bb, int shift) {
+    return shift > 0 ? _mm256_slli_epi64(bb, shift) : _mm256_srli_epi64(bb, -shift);
+}
+
+__attribute__((target("avx2")))
+static void count_knights_avx2(const u64* pieces, int count, u64 targets_bb, int* moves) {
+    __m256i targets = _mm256_set1_epi64x((long long)targets_bb);
+    for (int first = 0; first < count; first += 4) {
+        u64 lanes[4] __attribute__((aligned(32))) = {0, 0, 0, 0};
+        for (int i = 0; i < 4 && first + i < count; i++) lanes[i] = pieces[first + i];
+
+        __m256i group = _mm256_load_si256((const __m256i*)lanes);
+        __m256i attacks = _mm256_setzero_si256();
+        for (int j = 0; j < 8; j++) {
+            __m256i wrap = _mm256_set1_epi64x((long long)knight_jumps[j].wrap);
+            attacks = _mm256_or_si256(attacks, _mm256_and_si256(shift_vector(group, knight_jumps[j].shift), wrap));
+        }
+        _mm256_store_si256((__m256i*)lanes, _mm256_and_si256(attacks, targets));
+        for (int i = 0; i < 4 && first + i < count; i++) moves[first + i] = __builtin_popcountll(lanes[i]);
+    }
+}
+
+__attribute__((target("avx2")))
+static void mobility_setwise_avx2(const Board* board, int side, Mobility* out) {
+    u64 pieces[4][MOBILITY_MAX_PIECES];
+    collect_pieces(board, side, pieces, out);
+    u64 targets = ~board->occupancies[side];
+    u64 empty = ~board->occupancies[BOTH];
+
+    RayFill diagonal_fill, orthogonal_fill;
+    prepare_fill(&diagonal_fill, &diagonal_lanes, empty);
+    prepare_fill(&orthogonal_fill, &orthogonal_lanes, empty);
+
+    count_knights_avx2(pieces[0], out->count[0], targets, out->moves[0]);
+    for (int i = 0; i < out->count[1]; i++) out->moves[1][i] = popcount(slide_avx2(pieces[1][i], &diagonal_fill) & targets);
+    for (int i = 0; i < out->count[2]; i++) out->moves[2][i] = popcount(slide_avx2(pieces[2][i], &orthogonal_fill) & targets);
+    for (int i = 0; i < out->count[3]; i++) {
+        u64 attacks = slide_avx2(pieces[3][i], &orthogonal_fill) | slide_avx2(pieces[3][i], &diagonal_fill);
+        out->moves[3][i] = popcount(attacks & targets);
+    }
+}
+#endif
+
+// --- Kernel Selection ---
+
+MobilityKernel mobility_kernel = MOBILITY_MAGIC;
+static void (*setwise_kernel)(const Board*, int, Mobility*) = mobility_setwise_scalar;
+
+void init_mobility() {
+#ifdef MOBILITY_X86
+    build_ray_lanes(&diagonal_lanes, diagonal);
+    build_ray_lanes(&orthogonal_lanes, orthogonal);
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) setwise_kernel = mobility_setwise_avx2;
+#endif
+}
+
+void mobility_setwise(const Board* board, int side, Mobility* out) {
+    setwise_kernel(board, side, out);
+}
+
+void set_mobility_kernel(MobilityKernel kernel) {
+    mobility_kernel = kernel;
+}
+
+const char* mobility_kernel_name() {
+    if (mobility_kernel == MOBILITY_MAGIC) return "magic";
+    return setwise_kernel == mobility_setwise_scalar ? "setwise-scalar" : "setwise-avx2";
+}
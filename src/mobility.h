@@ -0,0 +1,39 @@
+// src/mobility.h
+
+#ifndef MOBILITY_H
+#define MOBILITY_H
+
+#include "board.h"
+
+// Per-piece mobility of one side for evaluate(): the number of squares each
+// knight, bishop, rook and queen attacks that don't hold a piece of its own
+// side, in square order within each type.
+#define MOBILITY_MAX_PIECES 10  // Two originals plus eight promotions
+
+typedef struct {
+    int count[4];                     // Knights, bishops, rooks, queens
+    int moves[4][MOBILITY_MAX_PIECES];
+} Mobility;
+
+// Two interchangeable kernels. The magic kernel does one attack lookup per
+// piece. The set-wise kernel computes attacks with Kogge-Stone occluded
+// fills (shifts and masks only, no tables); with AVX2 a slider's four ray
+// directions share one vector and knights go four to a vector.
+typedef enum { MOBILITY_MAGIC, MOBILITY_SETWISE } MobilityKernel;
+
+void mobility_magic(const Board* board, int side, Mobility* out);
+// AVX2 or scalar, whichever init_mobility() picked for this CPU
+void mobility_setwise(const Board* board, int side, Mobility* out);
+void mobility_setwise_scalar(const Board* board, int side, Mobility* out);
+
+// Picks the set-wise implementation. Called by init_engine().
+void init_mobility();
+
+// The kernel evaluate() uses (magic by default, which evaluate() inlines).
+// Set it before searching.
+extern MobilityKernel mobility_kernel;
+void set_mobility_kernel(MobilityKernel kernel);
+// "magic", "setwise-avx2" or "setwise-scalar"
+const char* mobility_kernel_name();
+
+#endif // MOBILITY_H
@@ -302,10 +302,98 @@ int is_square_attacked(int square, int side, const Board* board) {
     return 0;
 }
 
-void generate_all_pawn_moves(const Board* board, MoveList* move_list) {
+// --- Static Exchange Evaluation ---
+// Piece values used only to resolve capture sequences, indexed by piece type.
+const int see_piece_values[6] = { 100, 300, 300, 500, 900, 20000 };
+
+// All pieces of both colours attacking 'square' given the occupancy 'occ'.
+// Passing a modified occupancy lets sliders "see through" pieces that have
+// already been exchanged off (x-ray attacks).
+static u64 attackers_to_square(const Board* board, int square, u64 occ) {
+    const u64* bb = board->piece_bitboards;
+    u64 diagonal = bb[B] | bb[b] | bb[Q] | bb[q];
+    u64 straight = bb[R] | bb[r] | bb[Q] | bb[q];
+
+    return (pawn_attacks[BLACK][square] & bb[P])
+         | (pawn_attacks[WHITE][square] & bb[p])
+         | (knight_attacks[square] & (bb[N] | bb[n]))
+         | (king_attacks[square] & (bb[K] | bb[k]))
+         | (bishopAttacks(occ, square) & diagonal)
+         | (rookAttacks(occ, square) & straight);
+}
+
+// Returns the material balance (in see_piece_values units) of the capture
+// sequence started by 'move' on its destination square, assuming both sides
+// always recapture with their least valuable attacker and may stop at any point.
+int see(const Board* board, Move move) {
+    int gain[32];
+    int depth = 0;
+    int to = move.to;
+    int side = board->side_to_move;
+    u64 occ = board->occupancies[BOTH];
+
+    // Value of whatever is captured first
+    int victim_value = 0;
+    if (move.is_enpassant) {
+        victim_value = see_piece_values[P];
+        occ ^= 1ULL << ((side == WHITE) ? to - 8 : to + 8);
+    } else {
+        for (int piece = P; piece <= k; piece++) {
+            if ((board->piece_bitboards[piece] >> to) & 1) {
+                victim_value = see_piece_values[piece % 6];
+                break;
+            }
+        }
+    }
+
+    // The piece now standing on the square (a promoted pawn is worth its new piece)
+    int on_square = see_piece_values[move.piece % 6];
+    gain[0] = victim_value;
+    if (move.promotion) {
+        on_square = see_piece_values[move.promotion % 6];
+        gain[0] += on_square - see_piece_values[P];
+    }
+
+    occ ^= 1ULL << move.from;
+    u64 attackers = attackers_to_square(board, to, occ) & occ;
+    side = !side;
+
+    while (depth < 31) {
+        // Speculative gain if the piece now on the square gets recaptured
+        depth++;
+        gain[depth] = on_square - gain[depth - 1];
+        // Neither side can improve by continuing the exchange
+        if ((-gain[depth - 1] > gain[depth] ? -gain[depth - 1] : gain[depth]) < 0) break;
+
+        // Least valuable attacker of the side to recapture
+        int attacker = -1;
+        u64 attacker_bb = 0;
+        for (int piece = P; piece <= K; piece++) {
+            attacker_bb = attackers & board->piece_bitboards[side == WHITE ? piece : piece + 6];
+            if (attacker_bb) { attacker = piece; break; }
+        }
+        if (attacker == -1) break;
+
+        occ ^= attacker_bb & -attacker_bb;
+        attackers = attackers_to_square(board, to, occ) & occ;
+        on_square = see_piece_values[attacker];
+        side = !side;
+    }
+
+    // Negamax the gains back to the start of the exchange; the last entry is
+    // speculative (no recapture was found or it was pruned) and is skipped
+    while (--depth > 0) {
+        if (-gain[depth - 1] < gain[depth]) gain[depth - 1] = -gain[depth];
+    }
+    return gain[0];
+}
+
+// --- Pawn Move Helpers ---
+// Pushes (including push-promotions) and captures (including en passant) are
+// generated separately so the search can ask for captures or quiets only.
+static void generate_pawn_pushes(const Board* board, MoveList* move_list) {
     int side = board->side_to_move;
     u64 my_pawns = board->piece_bitboards[side == WHITE ? P : p];
-    u64 enemy_pieces = board->occupancies[!side];
     u64 all_pieces = board->occupancies[BOTH];
 
     int from_square, to_square;
@@ -313,11 +401,8 @@ void generate_all_pawn_moves(const Board* board, MoveList* move_list) {
     // White promotes on rank 8, Black promotes on rank 1.
     u64 promotion_rank = (side == WHITE) ? 0xFF00000000000000ULL : 0x00000000000000FFULL;
 
-    // --- 1. Pawn Pushes and Promotions ---
     u64 single_pushes = (side == WHITE) ? (my_pawns << 8) & ~all_pieces : (my_pawns >> 8) & ~all_pieces;
     u64 rank_for_double_push = (side == WHITE) ? 0x000000000000FF00ULL : 0x00FF000000000000ULL;
-    u64 pawns_on_start_rank = my_pawns & rank_for_double_push;
-    u64 double_push_targets = (side == WHITE) ? (pawns_on_start_rank << 16) : (pawns_on_start_rank >> 16);
     u64 double_pushes = (side == WHITE) ? ((single_pushes & (rank_for_double_push << 8)) << 8) & ~all_pieces : ((single_pushes & (rank_for_double_push >> 8)) >> 8) & ~all_pieces;
 
 
@@ -346,8 +431,16 @@ void generate_all_pawn_moves(const Board* board, MoveList* move_list) {
         move_list->moves[move_list->count++] = (Move){from_square, to_square, (side == WHITE ? P : p), 0, 0, 0, 0};
         double_pushes &= double_pushes - 1;
     }
+}
+
+static void generate_pawn_captures(const Board* board, MoveList* move_list) {
+    int side = board->side_to_move;
+    u64 my_pawns = board->piece_bitboards[side == WHITE ? P : p];
+    u64 enemy_pieces = board->occupancies[!side];
+
+    int from_square, to_square;
+    u64 promotion_rank = (side == WHITE) ? 0xFF00000000000000ULL : 0x00000000000000FFULL;
 
-    // --- 2. Pawn Captures ---
     u64 pawns_to_capture_from = my_pawns;
     while(pawns_to_capture_from) {
         from_square = __builtin_ctzll(pawns_to_capture_from);
@@ -370,7 +463,7 @@ void generate_all_pawn_moves(const Board* board, MoveList* move_list) {
             normal_captures &= normal_captures - 1;
         }
 
-        // --- 3. En Passant ---
+        // --- En Passant ---
         if (board->enpassant_square != -1) {
             u64 ep_attack = pawn_attacks[side][from_square] & (1ULL << board->enpassant_square);
             if (ep_attack) {
@@ -381,119 +474,84 @@ void generate_all_pawn_moves(const Board* board, MoveList* move_list) {
     }
 }
 
+void generate_all_pawn_moves(const Board* board, MoveList* move_list) {
+    // --- 1. Pawn Pushes and Promotions ---
+    generate_pawn_pushes(board, move_list);
 
-void generate_all_knight_moves(const Board* board, MoveList* move_list) {
-    int side = board->side_to_move;
-    u64 friendlies = board->occupancies[side];
-    u64 enemies = board->occupancies[!side];
-    u64 knights = board->piece_bitboards[side == WHITE ? N : n];
+    // --- 2. Pawn Captures and En Passant ---
+    generate_pawn_captures(board, move_list);
+}
 
-     while (knights) {
-        int from_square = __builtin_ctzll(knights);
-        u64 attacks = knight_attacks[from_square];
-        u64 valid_moves = attacks & ~friendlies;
-        
-        while (valid_moves) {
-            int to_square = __builtin_ctzll(valid_moves);
-            move_list->moves[move_list->count++] = (Move){ .from = from_square, .to = to_square, .piece = (side == WHITE ? N : n), .is_capture = (enemies & (1ULL << to_square)) ? 1 : 0, 0, 0 };
-            valid_moves &= valid_moves - 1;
-        }
+// --- Piece Move Helpers ---
+// Adds a move from 'from_square' to every square in 'targets' for 'piece'.
+static void add_piece_moves(const Board* board, MoveList* move_list, int piece, int from_square, u64 targets) {
+    u64 enemies = board->occupancies[piece < 6 ? BLACK : WHITE];
+
+    while (targets) {
+        int to_square = __builtin_ctzll(targets);
+        move_list->moves[move_list->count++] = (Move){ .from = from_square, .to = to_square, .piece = piece, .is_capture = (enemies & (1ULL << to_square)) ? 1 : 0, 0, 0 };
+        targets &= targets - 1;
+    }
+}
+
+// Knight, slider and king moves restricted to destinations in 'targets'.
+// Passing the empty or enemy squares lets callers split quiets from captures.
+static void generate_knight_moves_to(const Board* board, MoveList* move_list, u64 targets) {
+    int piece = board->side_to_move == WHITE ? N : n;
+    u64 knights = board->piece_bitboards[piece];
 
+    while (knights) {
+        int from_square = __builtin_ctzll(knights);
+        add_piece_moves(board, move_list, piece, from_square, knight_attacks[from_square] & targets);
         knights &= knights - 1;
     }
 }
 
-void generate_all_bishop_moves(const Board* board, MoveList* move_list) {
-    int side = board->side_to_move;
-    u64 friendly_pieces = board->occupancies[side];
-    u64 bishops = board->piece_bitboards[side == WHITE ? B : b];
+static void generate_bishop_moves_to(const Board* board, MoveList* move_list, u64 targets) {
+    int piece = board->side_to_move == WHITE ? B : b;
+    u64 bishops = board->piece_bitboards[piece];
 
     while (bishops) {
         int from_square = __builtin_ctzll(bishops);
-        u64 attacks = bishopAttacks(board->occupancies[2], from_square);
-        u64 valid_moves = attacks & ~friendly_pieces;
-
-        while (valid_moves) {
-            int to_square = __builtin_ctzll(valid_moves);
-            move_list->moves[move_list->count++] = (Move){ .from = from_square, .to = to_square, .piece = (side == WHITE ? B : b), .is_capture = (board->occupancies[!side] & (1ULL << to_square)) ? 1 : 0, 0, 0 };
-           
-            valid_moves &= valid_moves - 1;
-        }
-
+        add_piece_moves(board, move_list, piece, from_square, bishopAttacks(board->occupancies[2], from_square) & targets);
         bishops &= bishops - 1;
     }
 }
 
-void generate_all_rook_moves(const Board* board, MoveList* move_list) {
-    int side = board->side_to_move;
-    u64 friendly_pieces = board->occupancies[side];
-    // Get the bitboard for the rooks of the current side
-    u64 rooks = board->piece_bitboards[side == WHITE ? R : r];
+static void generate_rook_moves_to(const Board* board, MoveList* move_list, u64 targets) {
+    int piece = board->side_to_move == WHITE ? R : r;
+    u64 rooks = board->piece_bitboards[piece];
 
-    // Loop through each rook
     while (rooks) {
         int from_square = __builtin_ctzll(rooks);
-        // Get the attacks for that square using the rook magic lookup
-        u64 attacks = rookAttacks(board->occupancies[2], from_square);
-        // Filter out moves that land on friendly pieces
-        u64 valid_moves = attacks & ~friendly_pieces;
-
-        // Loop through the valid destination squares
-        while (valid_moves) {
-            int to_square = __builtin_ctzll(valid_moves);
-            // Create and add the move to the move list
-            move_list->moves[move_list->count++] = (Move){ .from = from_square, .to = to_square, .piece = (side == WHITE ? R : r), .is_capture = (board->occupancies[!side] & (1ULL << to_square)) ? 1 : 0, 0, 0 };
-            // Clear the 'to' bit to continue the loop
-            valid_moves &= valid_moves - 1;
-        }
-        // Clear the 'from' bit to continue the outer loop
+        add_piece_moves(board, move_list, piece, from_square, rookAttacks(board->occupancies[2], from_square) & targets);
         rooks &= rooks - 1;
     }
 }
 
-void generate_all_queen_moves(const Board* board, MoveList* move_list) {
-    int side = board->side_to_move;
-    u64 friendly_pieces = board->occupancies[side];
-    // Get the bitboard for the queens of the current side
-    u64 queens = board->piece_bitboards[side == WHITE ? Q : q];
+static void generate_queen_moves_to(const Board* board, MoveList* move_list, u64 targets) {
+    int piece = board->side_to_move == WHITE ? Q : q;
+    u64 queens = board->piece_bitboards[piece];
 
-    // Loop through each queen
     while (queens) {
         int from_square = __builtin_ctzll(queens);
-
         // Get bishop and rook attacks from the same square and combine them
-        u64 bishop_attacks = bishopAttacks(board->occupancies[2], from_square);
-        u64 rook_attacks = rookAttacks(board->occupancies[2], from_square);
-        u64 attacks = bishop_attacks | rook_attacks;
-
-        // Filter out moves that land on friendly pieces
-        u64 valid_moves = attacks & ~friendly_pieces;
-
-        // Loop through the valid destination squares
-        while (valid_moves) {
-            int to_square = __builtin_ctzll(valid_moves);
-            // Create and add the move to the move list
-            move_list->moves[move_list->count++] = (Move){ .from = from_square, .to = to_square, .piece = (side == WHITE ? Q : q), .is_capture = (board->occupancies[!side] & (1ULL << to_square)) ? 1 : 0, 0, 0 };
-            // Clear the 'to' bit to continue the loop
-            valid_moves &= valid_moves - 1;
-        }
-        // Clear the 'from' bit to continue the outer loop
+        u64 attacks = bishopAttacks(board->occupancies[2], from_square) | rookAttacks(board->occupancies[2], from_square);
+        add_piece_moves(board, move_list, piece, from_square, attacks & targets);
         queens &= queens - 1;
     }
 }
 
-void generate_all_king_moves(const Board* board, MoveList* move_list) {
+static void generate_king_moves_to(const Board* board, MoveList* move_list, u64 targets) {
+    int piece = board->side_to_move == WHITE ? K : k;
+    int from_square = __builtin_ctzll(board->piece_bitboards[piece]);
+
+    add_piece_moves(board, move_list, piece, from_square, king_attacks[from_square] & targets);
+}
+
+static void generate_castling_moves(const Board* board, MoveList* move_list) {
     int side = board->side_to_move;
-    u64 friendly_pieces = board->occupancies[side];
     int from_square = __builtin_ctzll(board->piece_bitboards[side == WHITE ? K : k]);
-    u64 attacks = king_attacks[from_square];
-    u64 valid_moves = attacks & ~friendly_pieces;
-
-    while (valid_moves) {
-        int to_square = __builtin_ctzll(valid_moves);
-        move_list->moves[move_list->count++] = (Move){ .from = from_square, .to = to_square, .piece = (side == WHITE ? K : k), .is_capture = (board->occupancies[!side] & (1ULL << to_square)) ? 1 : 0, 0, 0 };
-        valid_moves &= valid_moves - 1;
-    }
 
     if (is_square_attacked(from_square, !side, board)) {
         return; // King in check, no castling allowed
@@ -524,6 +582,27 @@ void generate_all_king_moves(const Board* board, MoveList* move_list) {
     }
 }
 
+void generate_all_knight_moves(const Board* board, MoveList* move_list) {
+    generate_knight_moves_to(board, move_list, ~board->occupancies[board->side_to_move]);
+}
+
+void generate_all_bishop_moves(const Board* board, MoveList* move_list) {
+    generate_bishop_moves_to(board, move_list, ~board->occupancies[board->side_to_move]);
+}
+
+void generate_all_rook_moves(const Board* board, MoveList* move_list) {
+    generate_rook_moves_to(board, move_list, ~board->occupancies[board->side_to_move]);
+}
+
+void generate_all_queen_moves(const Board* board, MoveList* move_list) {
+    generate_queen_moves_to(board, move_list, ~board->occupancies[board->side_to_move]);
+}
+
+void generate_all_king_moves(const Board* board, MoveList* move_list) {
+    generate_king_moves_to(board, move_list, ~board->occupancies[board->side_to_move]);
+    generate_castling_moves(board, move_list);
+}
+
 void generate_all_moves(const Board* board, MoveList* move_list) {
     move_list->count = 0; // Reset move count
     
@@ -535,6 +614,76 @@ void generate_all_moves(const Board* board, MoveList* move_list) {
     generate_all_king_moves(board, move_list);
 }
 
+// Appends only the captures (including en passant and capture-promotions).
+void generate_all_captures(const Board* board, MoveList* move_list) {
+    u64 enemies = board->occupancies[!board->side_to_move];
+
+    generate_pawn_captures(board, move_list);
+    generate_knight_moves_to(board, move_list, enemies);
+    generate_bishop_moves_to(board, move_list, enemies);
+    generate_rook_moves_to(board, move_list, enemies);
+    generate_queen_moves_to(board, move_list, enemies);
+    generate_king_moves_to(board, move_list, enemies);
+}
+
+// Appends only the non-captures (including push-promotions and castling).
+// Together with generate_all_captures() this yields the same set of moves
+// as generate_all_moves().
+void generate_all_quiets(const Board* board, MoveList* move_list) {
+    u64 empty = ~board->occupancies[BOTH];
+
+    generate_pawn_pushes(board, move_list);
+    generate_knight_moves_to(board, move_list, empty);
+    generate_bishop_moves_to(board, move_list, empty);
+    generate_rook_moves_to(board, move_list, empty);
+    generate_queen_moves_to(board, move_list, empty);
+    generate_king_moves_to(board, move_list, empty);
+    generate_castling_moves(board, move_list);
+}
+
+// Packs the identifying parts of a move into an int for compact storage in
+// the transposition table. 0 is never a real move (from == to) and means none.
+int pack_move(Move move) {
+    return move.from | (move.to << 6) | (move.promotion << 12);
+}
+
+// Rebuilds a full Move from a packed from/to/promotion code (see pack_move())
+// by generating the moves of the piece standing on the from-square. Returns 1
+// and fills 'move' only if the move is pseudo-legal in this position, which
+// guards against stale or colliding hash moves and killers.
+int unpack_move(const Board* board, int packed, Move* move) {
+    int from = packed & 0x3F;
+    int to = (packed >> 6) & 0x3F;
+    int promotion = (packed >> 12) & 0xF;
+    int side = board->side_to_move;
+
+    if (packed == 0 || !((board->occupancies[side] >> from) & 1)) return 0;
+
+    int piece = -1;
+    for (int pc = (side == WHITE ? P : p); pc <= (side == WHITE ? K : k); pc++) {
+        if ((board->piece_bitboards[pc] >> from) & 1) { piece = pc; break; }
+    }
+
+    MoveList piece_moves = { .count = 0 };
+    switch (piece % 6) {
+        case P: generate_all_pawn_moves(board, &piece_moves); break;
+        case N: generate_all_knight_moves(board, &piece_moves); break;
+        case B: generate_all_bishop_moves(board, &piece_moves); break;
+        case R: generate_all_rook_moves(board, &piece_moves); break;
+        case Q: generate_all_queen_moves(board, &piece_moves); break;
+        case K: generate_all_king_moves(board, &piece_moves); break;
+    }
+
+    for (int i = 0; i < piece_moves.count; i++) {
+        Move candidate = piece_moves.moves[i];
+        if (candidate.from == from && candidate.to == to && candidate.promotion == promotion) {
+            *move = candidate;
+            return 1;
+        }
+    }
+    return 0;
+}
+
 // --- Main Initialization Entry Point ---
 void init_attack_tables() {
     generate_pawn_attacks();
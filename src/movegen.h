@@ -43,4 +43,16 @@ void generate_all_queen_moves(const Board* board, MoveList* move_list);
 void generate_all_king_moves(const Board* board, MoveList* move_list);
 void generate_all_moves(const Board* board, MoveList* move_list);
 
+// Static exchange evaluation of a capture, in centipawns
+extern const int see_piece_values[6];
+int see(const Board* board, Move move);
+
+// Staged generation: captures and quiets separately, appended to the list
+void generate_all_captures(const Board* board, MoveList* move_list);
+void generate_all_quiets(const Board* board, MoveList* move_list);
+
+// Compact move encoding used by the transposition table
+int pack_move(Move move);
+int unpack_move(const Board* board, int packed, Move* move);
+
 #endif // MOVEGEN_H
\ No newline at end of file
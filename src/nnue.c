@@ -0,0 +1,260 @@
+// src/nnue.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86
+#endif
+
+#include "nnue.h"
+
+#define NNUE_MAGIC "SCYNNUE1"
+
+typedef struct {
+    i16 ft_biases[NNUE_HIDDEN] __attribute__((aligned(32)));
+    i16 ft_weights[NNUE_INPUTS][NNUE_HIDDEN] __attribute__((aligned(32)));
+    i32 output_bias;
+    int8_t output_weights[2 * NNUE_HIDDEN] __attribute__((aligned(32)));
+} NnueNetwork;
+
+static NnueNetwork* network = NULL;
+static int use_network = 0;
+
+// --- Kernels ---
+// The accumulator updates are plain 16-bit vector adds, and the output layer
+// packs the clipped accumulator to unsigned bytes for an 8-bit dot product.
+// AVX2 versions are picked at load time when the CPU has them.
+
+static void add_column_scalar(i16* values, const i16* column) {
+    for (int i = 0; i < NNUE_HIDDEN; i++) values[i] += column[i];
+}
+
+static void sub_column_scalar(i16* values, const i16* column) {
+    for (int i = 0; i < NNUE_HIDDEN; i++) values[i] -= column[i];
+}
+
+static int output_dot_scalar(const i16* values, const int8_t* weights) {
+    int sum = 0;
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        int clipped = values[i] < 0 ? 0 : values[i] > NNUE_CLIP ? NNUE_CLIP : values[i];
+        sum += clipped * weights[i];
+    }
+    return sum;
+}
+
+#ifdef NNUE_X86
+__attribute__((target("avx2")))
+static void add_column_avx2(i16* values, const i16* column) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i v = _mm256_load_si256((const __m256i*)(values + i));
+        __m256i c = _mm256_load_si256((const __m256i*)(column + i));
+        _mm256_store_si256((__m256i*)(values + i), _mm256_add_epi16(v, c));
+    }
+}
+
+__attribute__((target("avx2")))
+static void sub_column_avx2(i16* values, const i16* column) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i v = _mm256_load_si256((const __m256i*)(values + i));
+        __m256i c = _mm256_load_si256((const __m256i*)(column + i));
+        _mm256_store_si256((__m256i*)(values + i), _mm256_sub_epi16(v, c));
+    }
+}
+
+__attribute__((target("avx2")))
+static int output_dot_avx2(const i16* values, const int8_t* weights) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i clip = _mm256_set1_epi16(NNUE_CLIP);
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+
+    for (int i = 0; i < NNUE_HIDDEN; i += 32) {
+        __m256i low = _mm256_load_si256((const __m256i*)(values + i));
+        __m256i high = _mm256_load_si256((const __m256i*)(values + i + 16));
+        low = _mm256_min_epi16(_mm256_max_epi16(low, zero), clip);
+        high = _mm256_min_epi16(_mm256_max_epi16(high, zero), clip);
+        // packus works per 128-bit lane; put the 64-bit blocks back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+        __m256i w = _mm256_load_si256((const __m256i*)(weights + i));
+        // 127 * 127 * 2 fits in the 16-bit pair sums of maddubs
+        __m256i products = _mm256_maddubs_epi16(packed, w);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+
+    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4E));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xB1));
+    return _mm_cvtsi128_si32(sum128);
+}
+#endif
+
+static void (*add_column)(i16*, const i16*) = add_column_scalar;
+static void (*sub_column)(i16*, const i16*) = sub_column_scalar;
+static int (*output_dot)(const i16*, const int8_t*) = output_dot_scalar;
+static const char* kernel_name = "scalar";
+static int scalar_only = 0;
+
+static void select_kernels() {
+    add_column = add_column_scalar;
+    sub_column = sub_column_scalar;
+    output_dot = output_dot_scalar;
+    kernel_name = "scalar";
+#ifdef NNUE_X86
+    __builtin_cpu_init();
+    if (!scalar_only && __builtin_cpu_supports("avx2")) {
+        add_column = add_column_avx2;
+        sub_column = sub_column_avx2;
+        output_dot = output_dot_avx2;
+        kernel_name = "avx2";
+    }
+#endif
+}
+
+// --- Loading ---
+
+int nnue_load(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return 0;
+
+    NnueNetwork* loaded = aligned_alloc(32, sizeof(NnueNetwork));
+    char magic[8];
+    u32 hidden;
+    int ok = loaded != NULL
+        && fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, NNUE_MAGIC, sizeof(magic)) == 0
+        && fread(&hidden, sizeof(hidden), 1, file) == 1 && hidden == NNUE_HIDDEN
+        && fread(loaded->ft_biases, sizeof(loaded->ft_biases), 1, file) == 1
+        && fread(loaded->ft_weights, sizeof(loaded->ft_weights), 1, file) == 1
+        && fread(&loaded->output_bias, sizeof(loaded->output_bias), 1, file) == 1
+        && fread(loaded->output_weights, sizeof(loaded->output_weights), 1, file) == 1
+        && fgetc(file) == EOF;
+    fclose(file);
+
+    if (!ok) {
+        free(loaded);
+        return 0;
+    }
+    free(network);
+    network = loaded;
+    use_network = 1;
+    select_kernels();
+    return 1;
+}
+
+void nnue_set_enabled(int enabled) {
+    use_network = enabled;
+}
+
+int nnue_enabled() {
+    return network != NULL && use_network;
+}
+
+const char* nnue_kernel() {
+    return kernel_name;
+}
+
+void nnue_force_scalar(int scalar) {
+    scalar_only = scalar;
+    select_kernels();
+}
+
+NnueStack* nnue_create_stack() {
+    return aligned_alloc(32, sizeof(NnueStack));
+}
+
+void nnue_destroy_stack(NnueStack* stack) {
+    free(stack);
+}
+
+// --- Accumulators ---
+
+static int king_square(const Board* board, int perspective) {
+    u64 king_bb = board->piece_bitboards[perspective == WHITE ? K : k];
+    return king_bb ? __builtin_ctzll(king_bb) : 0;
+}
+
+static const i16* feature_column(int perspective, int king_sq, int piece, int square) {
+    int type = piece % 6;
+    int relative = (piece < 6) == (perspective == WHITE) ? type : type + 5;
+    if (perspective == BLACK) {
+        king_sq ^= 56;
+        square ^= 56;
+    }
+    return network->ft_weights[(king_sq * NNUE_PIECE_TYPES + relative) * 64 + square];
+}
+
+// Sums every feature of one perspective from scratch
+static void refresh(NnueAccumulator* acc, const Board* board, int perspective) {
+    int king_sq = king_square(board, perspective);
+    memcpy(acc->values[perspective], network->ft_biases, sizeof(acc->values[perspective]));
+
+    for (int piece = P; piece <= q; piece++) {
+        if (piece == K) continue;
+        u64 bitboard = board->piece_bitboards[piece];
+        while (bitboard) {
+            add_column(acc->values[perspective], feature_column(perspective, king_sq, piece, __builtin_ctzll(bitboard)));
+            bitboard &= bitboard - 1;
+        }
+    }
+}
+
+void nnue_attach(Board* board, NnueStack* stack) {
+    board->nnue = network ? stack : NULL;
+    if (board->nnue == NULL) return;
+    refresh(&stack->accumulators[board->ply], board, WHITE);
+    refresh(&stack->accumulators[board->ply], board, BLACK);
+}
+
+// Derives the accumulator of the new ply from the previous one. Kings are
+// not features, but every feature of a side depends on its king square, so
+// a king move refreshes the mover's perspective instead.
+void nnue_make_move(Board* board, Move move) {
+    NnueAccumulator* acc = &board->nnue->accumulators[board->ply];
+    const NnueAccumulator* previous = acc - 1;
+    int mover = !board->side_to_move;
+    int king_move = move.piece == K || move.piece == k;
+    int captured = board->history[board->ply - 1].captured_piece;
+    int captured_sq = move.is_enpassant ? (mover == WHITE ? move.to - 8 : move.to + 8) : move.to;
+
+    for (int perspective = WHITE; perspective <= BLACK; perspective++) {
+        if (king_move && perspective == mover) {
+            refresh(acc, board, perspective);
+            continue;
+        }
+
+        i16* values = acc->values[perspective];
+        int king_sq = king_square(board, perspective);
+        memcpy(values, previous->values[perspective], sizeof(acc->values[perspective]));
+
+        if (!king_move) {
+            sub_column(values, feature_column(perspective, king_sq, move.piece, move.from));
+            add_column(values, feature_column(perspective, king_sq, move.promotion ? move.promotion : move.piece, move.to));
+        }
+        if (captured != -1 && captured != K && captured != k) {
+            sub_column(values, feature_column(perspective, king_sq, captured, captured_sq));
+        }
+        if (move.is_castle) {
+            int rook = mover == WHITE ? R : r;
+            int rook_from = move.to > move.from ? move.to + 1 : move.to - 2;
+            int rook_to = move.to > move.from ? move.to - 1 : move.to + 1;
+            sub_column(values, feature_column(perspective, king_sq, rook, rook_from));
+            add_column(values, feature_column(perspective, king_sq, rook, rook_to));
+        }
+    }
+}
+
+void nnue_make_null_move(Board* board) {
+    NnueAccumulator* acc = &board->nnue->accumulators[board->ply];
+    memcpy(acc, acc - 1, sizeof(*acc));
+}
+
+int nnue_evaluate(const Board* board) {
+    const NnueAccumulator* acc = &board->nnue->accumulators[board->ply];
+    int us = board->side_to_move;
+    int output = network->output_bias
+        + output_dot(acc->values[us], network->output_weights)
+        + output_dot(acc->values[!us], network->output_weights + NNUE_HIDDEN);
+    return output / NNUE_OUTPUT_SCALE;
+}
@@ -0,0 +1,72 @@
+// src/nnue.h
+
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "board.h"
+
+// Efficiently updatable neural network evaluation (HalfKP style).
+//
+// Each side looks at the board from its own king: an input feature is
+// (own king square, non-king piece relative to that side, square), with
+// Black's squares mirrored so both perspectives share one set of weights.
+// The feature transformer sums the weight columns of the active features
+// into a 16-bit accumulator per perspective, and make_move() keeps those
+// sums up to date instead of recomputing them (only a king move refreshes
+// its own side). The output layer clips both accumulators to [0, 127],
+// side to move first, and takes the dot product with 8-bit weights.
+//
+// Network file, all values little-endian:
+//   char magic[8]                              "SCYNNUE1"
+//   u32  hidden size                           must be NNUE_HIDDEN
+//   i16  ft_biases[NNUE_HIDDEN]
+//   i16  ft_weights[NNUE_INPUTS][NNUE_HIDDEN]  one column per feature
+//   i32  output_bias
+//   i8   output_weights[2 * NNUE_HIDDEN]       side to move, then the other
+// The score is (output_bias + dot product) / NNUE_OUTPUT_SCALE centipawns.
+
+#define NNUE_PIECE_TYPES 10  // P..Q of the perspective's side, then of the other
+#define NNUE_INPUTS (64 * NNUE_PIECE_TYPES * 64)
+#define NNUE_HIDDEN 256
+#define NNUE_CLIP 127
+#define NNUE_OUTPUT_SCALE 16
+
+typedef struct {
+    i16 values[2][NNUE_HIDDEN] __attribute__((aligned(32)));  // [perspective]
+} NnueAccumulator;
+
+// One accumulator per board ply, indexed like Board.history. Each search
+// context owns one and attaches it to the board it is searching.
+struct NnueStack {
+    NnueAccumulator accumulators[MAX_GAME_PLY];
+};
+typedef struct NnueStack NnueStack;
+
+// Loads a network shared by all searches; don't call it while one runs.
+// Enables NNUE evaluation and returns 1 on success, 0 if the file is
+// missing or malformed (the previous network, if any, stays loaded).
+int nnue_load(const char* path);
+// Choose between the loaded network and the classical evaluation
+void nnue_set_enabled(int enabled);
+int nnue_enabled();
+// "avx2" or "scalar", depending on what this CPU supports
+const char* nnue_kernel();
+// Forces the scalar kernels (1), or goes back to the fastest ones this CPU
+// supports (0), so the two can be checked against each other. Like
+// nnue_load(), not while a search runs.
+void nnue_force_scalar(int scalar);
+
+NnueStack* nnue_create_stack();
+void nnue_destroy_stack(NnueStack* stack);
+
+// Makes the board keep 'stack' up to date from its current ply on (NULL
+// detaches it). The accumulator of the current position is computed here.
+void nnue_attach(Board* board, NnueStack* stack);
+// Called by make_move()/make_null_move() after the board has been updated
+void nnue_make_move(Board* board, Move move);
+void nnue_make_null_move(Board* board);
+
+// Score of an attached board, in centipawns for the side to move
+int nnue_evaluate(const Board* board);
+
+#endif // NNUE_H
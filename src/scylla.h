@@ -0,0 +1,17 @@
+// src/scylla.h
+// Public header of the embeddable engine library (libscylla). Call
+// init_engine() once, then give each concurrent game its own SearchContext.
+
+#ifndef SCYLLA_H
+#define SCYLLA_H
+
+#include "defs.h"
+#include "board.h"
+#include "movegen.h"
+#include "evaluate.h"
+#include "transpose.h"
+#include "search.h"
+#include "nnue.h"
+#include "mobility.h"
+
+#endif // SCYLLA_H
@@ -1,12 +1,22 @@
 // src/search.c
 
 #include <stdio.h>
-#include <stdlib.h> // for qsort
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <math.h>   // for log
+#include <time.h>   // for clock_gettime
 #include "search.h"
 #include "evaluate.h"
 #include "movegen.h"
 #include "board.h"
 #include "transpose.h"
+#include "nnue.h"
+#include "mobility.h"
+
+// Margin on top of the captured piece's value for delta pruning in quiescence search
+#define DELTA_MARGIN 200
 
 // --- Move Ordering ---
 // Assigns a score to each move to help the search algorithm
@@ -42,219 +52,1388 @@ static int get_piece_on_square(Board* board, int square) {
     return -1;
 }
 
-static int compare_moves(const void* a, const void* b) {
-    return ((Move*)b)->score - ((Move*)a)->score;
+
+// --- Search Context ---
+// Everything a search writes lives in its context, so independent searches
+// can run side by side in one process. The attack tables, Zobrist keys,
+// evaluation masks and LMR table are shared and read-only after init_engine().
+
+// Per-ply state shared between a node and its ancestors/descendants.
+typedef struct {
+    int static_eval;    // Used to tell whether we're improving on two plies ago
+    Move excluded_move; // Set while verifying a singular TT move
+    Move current_move;  // The move being searched from this ply (none for a null move)
+} SearchStack;
+
+// Quiet move scores that depend on an earlier move: [piece][to] of the move
+typedef int PieceToHistory[12][64];
+
+struct SearchContext {
+    TranspositionTable tt;
+
+    // Quiet move heuristics, kept (and aged) across searches
+    Move killer_moves[2][MAX_PLY];
+    int history_moves[2][64][64];
+    Move counter_moves[12][64];                       // [prev piece][prev to]
+    PieceToHistory continuation_history[2][12][64];   // [plies back - 1][prev piece][prev to]
+
+    SearchStack stack[MAX_PLY];
+    // The board's ply when the current search started. Board plies count game
+    // moves too, so per-ply search tables are indexed relative to this.
+    int root_ply;
+    // Extensions may push the search at most this many plies beyond the
+    // nominal iteration depth, so forcing lines can't explode the tree.
+    int root_depth;
+    int root_side;
+
+    // MultiPV: moves already reported by earlier slots of this iteration,
+    // and the ranked results of the last completed iteration
+    Move root_excluded[MAX_MULTIPV];
+    int root_excluded_count;
+    RootLine root_lines[MAX_MULTIPV];
+    int root_line_count;
+
+    // Limits and clock of the current search
+    SearchLimits limits;
+    long nodes;
+    volatile int stopped;
+    int pondering;              // Search thread only; see ponderhit_context()
+    atomic_int ponderhit_pending;
+    long long ponderhit_time;   // Published by the release store of ponderhit_pending
+    pthread_mutex_t ponder_lock; // With ponder_cond, wakes a ponder search waiting
+    pthread_cond_t ponder_cond;  // at the end for the ponderhit or stop
+    long long start_time;
+    long long clock_start_time; // When the time limits started counting
+    long long soft_time_limit;  // Don't start another iteration past this (0 = none)
+    long long hard_time_limit;  // Abort the search mid-iteration past this (0 = none)
+    long node_limit;
+
+    SearchStats stats;
+    FILE* output; // Where info/bestmove lines go, NULL for none
+    NnueStack* nnue; // Accumulators for the searched board, allocated once NNUE is enabled
+};
+
+static int search_ply(SearchContext* ctx, const Board* board) {
+    return board->ply - ctx->root_ply;
+}
+
+// --- Quiet Move Heuristics ---
+// Killer moves are quiet moves that caused a beta cutoff at the same ply in a
+// sibling node. The history table accumulates a score for every quiet move
+// (indexed by [side][from][to]) that has caused cutoffs anywhere in the tree.
+// Counter moves and continuation history add context: the quiet move that
+// refuted the opponent's last move, and how well a move has done following
+// the moves made one and two plies earlier.
+#define MAX_HISTORY 7000 // Saturation bound of every history entry
+
+static int same_move(Move a, Move b) {
+    return a.from == b.from && a.to == b.to && a.promotion == b.promotion;
+}
+
+static int is_move(Move move) {
+    return move.from != move.to;
+}
+
+// The move made 'plies_back' plies above 'ply' in the current line, if any
+static Move previous_move(SearchContext* ctx, int ply, int plies_back) {
+    int index = ply - plies_back;
+    return index >= 0 && index < MAX_PLY ? ctx->stack[index].current_move : (Move){0};
+}
+
+// "Gravity" update: the bonus shrinks as the entry approaches MAX_HISTORY, so
+// the table saturates smoothly instead of overflowing, and moves that stop
+// producing cutoffs drift back towards zero.
+static void apply_bonus(int* entry, int bonus) {
+    int abs_bonus = bonus < 0 ? -bonus : bonus;
+    *entry += bonus - *entry * abs_bonus / MAX_HISTORY;
 }
 
-static void score_moves(Board* board, MoveList* move_list) {
-    for (int i = 0; i < move_list->count; ++i) {
-        int score = 0;
-        Move* move = &move_list->moves[i];
+static void update_history(SearchContext* ctx, int side, Move move, Move previous[2], int bonus) {
+    apply_bonus(&ctx->history_moves[side][move.from][move.to], bonus);
+    for (int i = 0; i < 2; i++) {
+        if (is_move(previous[i])) {
+            apply_bonus(&ctx->continuation_history[i][previous[i].piece][previous[i].to][move.piece][move.to], bonus);
+        }
+    }
+}
 
-        if (move->is_capture) {
-            int victim = get_piece_on_square(board, move->to);
-            if (victim != -1) {
-                int attacker_idx = move->piece % 6;
-                int victim_idx = victim % 6;
-                score = mvv_lva_scores[victim_idx][attacker_idx] + 10000;
+// Combined history score of a quiet move, used for ordering and reductions
+static int quiet_history(SearchContext* ctx, int side, Move move, Move previous[2]) {
+    int score = ctx->history_moves[side][move.from][move.to];
+    for (int i = 0; i < 2; i++) {
+        if (is_move(previous[i])) {
+            score += ctx->continuation_history[i][previous[i].piece][previous[i].to][move.piece][move.to];
+        }
+    }
+    return score;
+}
+
+static void store_killer(SearchContext* ctx, int ply, Move move) {
+    if (ply >= MAX_PLY || same_move(ctx->killer_moves[0][ply], move)) return;
+    ctx->killer_moves[1][ply] = ctx->killer_moves[0][ply];
+    ctx->killer_moves[0][ply] = move;
+}
+
+// Rewards the quiet move that caused the cutoff and penalises the quiet moves
+// searched before it, since they were ordered ahead of it but failed.
+static void update_quiet_heuristics(SearchContext* ctx, Board* board, Move best, Move* quiets_tried, int quiet_count, int depth) {
+    int side = board->side_to_move;
+    int ply = search_ply(ctx, board);
+    int bonus = depth * depth;
+    if (bonus > 400) bonus = 400;
+
+    Move previous[2] = { previous_move(ctx, ply, 1), previous_move(ctx, ply, 2) };
+    store_killer(ctx, ply, best);
+    if (is_move(previous[0])) {
+        ctx->counter_moves[previous[0].piece][previous[0].to] = best;
+    }
+    update_history(ctx, side, best, previous, bonus);
+    for (int i = 0; i < quiet_count; i++) {
+        update_history(ctx, side, quiets_tried[i], previous, -bonus);
+    }
+}
+
+// Called at the start of each search: killers only make sense for the previous
+// tree, while history is aged so it stays useful without dominating.
+static void age_heuristics(SearchContext* ctx) {
+    for (int ply = 0; ply < MAX_PLY; ply++) {
+        ctx->killer_moves[0][ply] = (Move){0};
+        ctx->killer_moves[1][ply] = (Move){0};
+    }
+    for (int side = 0; side < 2; side++) {
+        for (int from = 0; from < 64; from++) {
+            for (int to = 0; to < 64; to++) {
+                ctx->history_moves[side][from][to] /= 2;
             }
         }
-        move->score = score;
     }
-    qsort(move_list->moves, move_list->count, sizeof(Move), compare_moves);
+    int* continuation = &ctx->continuation_history[0][0][0][0][0];
+    for (size_t i = 0; i < sizeof(ctx->continuation_history) / sizeof(int); i++) {
+        continuation[i] /= 2;
+    }
 }
 
-static int quiescence_search(Board* board, int alpha, int beta) {
-    int stand_pat = evaluate(board);
-    if (stand_pat >= beta) return beta;
-    if (stand_pat > alpha) alpha = stand_pat;
+// --- Staged Move Picker ---
+// Most nodes cut off on the first or second move, so instead of generating,
+// scoring and sorting every move up front the picker hands out moves in stages
+// and only generates/sorts a stage when the search actually reaches it:
+//   TT move -> winning captures -> killers -> counter move -> quiets by history
+//   -> losing captures
+enum {
+    STAGE_TT_MOVE,
+    STAGE_INIT_CAPTURES,
+    STAGE_GOOD_CAPTURES,
+    STAGE_KILLER_1,
+    STAGE_KILLER_2,
+    STAGE_COUNTER_MOVE,
+    STAGE_INIT_QUIETS,
+    STAGE_QUIETS,
+    STAGE_BAD_CAPTURES,
+    STAGE_DONE
+};
 
-    MoveList move_list;
-    generate_all_moves(board, &move_list);
-    score_moves(board, &move_list);
+typedef struct {
+    SearchContext* ctx;
+    Board* board;
+    int stage;
+    int captures_only; // Quiescence search: winning captures only
+    int skip_quiets;   // Set by the search to prune the remaining quiet moves
+    Move tt_move;
+    int has_tt_move;
+    Move killers[2];
+    Move counter_move;
+    Move previous[2];  // Moves made one and two plies earlier, for continuation history
+    MoveList list;     // Captures first, quiets are appended behind them
+    int current;       // Next index to pick from in the current stage
+    int end;           // End of the current stage in 'list'
+    int bad_count;     // Losing captures are moved to list[0..bad_count)
+} MovePicker;
+
+// A capture is "winning" if the exchange it starts does not lose material.
+static int is_good_capture(Board* board, Move move) {
+    return see(board, move) >= 0;
+}
+
+static void init_move_picker(SearchContext* ctx, MovePicker* mp, Board* board, int tt_move, int captures_only) {
+    mp->ctx = ctx;
+    mp->board = board;
+    mp->captures_only = captures_only;
+    mp->skip_quiets = 0;
+    mp->list.count = 0;
+    mp->current = mp->end = mp->bad_count = 0;
+    mp->has_tt_move = unpack_move(board, tt_move, &mp->tt_move);
+    if (mp->has_tt_move && captures_only && !mp->tt_move.is_capture) {
+        mp->has_tt_move = 0;
+    }
+    mp->stage = mp->has_tt_move ? STAGE_TT_MOVE : STAGE_INIT_CAPTURES;
+
+    int ply = search_ply(ctx, board);
+    mp->killers[0] = ply < MAX_PLY ? ctx->killer_moves[0][ply] : (Move){0};
+    mp->killers[1] = ply < MAX_PLY ? ctx->killer_moves[1][ply] : (Move){0};
+    mp->previous[0] = previous_move(ctx, ply, 1);
+    mp->previous[1] = previous_move(ctx, ply, 2);
+    mp->counter_move = is_move(mp->previous[0]) ? ctx->counter_moves[mp->previous[0].piece][mp->previous[0].to] : (Move){0};
+}
+
+// Selection sort step: swaps the best-scored move of [current, end) to the
+// front and returns it. Cheaper than a full sort when only a few are used.
+static Move pick_best(MovePicker* mp) {
+    int best = mp->current;
+    for (int i = mp->current + 1; i < mp->end; i++) {
+        if (mp->list.moves[i].score > mp->list.moves[best].score) best = i;
+    }
+    Move move = mp->list.moves[best];
+    mp->list.moves[best] = mp->list.moves[mp->current];
+    mp->list.moves[mp->current++] = move;
+    return move;
+}
+
+static int is_tt_move(MovePicker* mp, Move move) {
+    return mp->has_tt_move && same_move(move, mp->tt_move);
+}
+
+static int is_killer(MovePicker* mp, Move move) {
+    return same_move(move, mp->killers[0]) || same_move(move, mp->killers[1]);
+}
+
+static int is_counter_move(MovePicker* mp, Move move) {
+    return is_move(mp->counter_move) && same_move(move, mp->counter_move);
+}
+
+// Returns 1 and fills 'move' with the next pseudo-legal move, 0 when done.
+static int next_move(MovePicker* mp, Move* move) {
+    Board* board = mp->board;
+
+    switch (mp->stage) {
+    case STAGE_TT_MOVE:
+        mp->stage = STAGE_INIT_CAPTURES;
+        *move = mp->tt_move;
+        return 1;
+
+    case STAGE_INIT_CAPTURES:
+        generate_all_captures(board, &mp->list);
+        for (int i = 0; i < mp->list.count; i++) {
+            Move* capture = &mp->list.moves[i];
+            int victim = capture->is_enpassant ? P : get_piece_on_square(board, capture->to);
+            capture->score = victim != -1 ? mvv_lva_scores[victim % 6][capture->piece % 6] : 0;
+        }
+        mp->current = 0;
+        mp->end = mp->list.count;
+        mp->stage = STAGE_GOOD_CAPTURES;
+        /* fall through */
+
+    case STAGE_GOOD_CAPTURES:
+        while (mp->current < mp->end) {
+            Move capture = pick_best(mp);
+            if (is_tt_move(mp, capture)) continue;
+            if (!is_good_capture(board, capture)) {
+                // bad_count never overtakes current, so this slot is free
+                mp->list.moves[mp->bad_count++] = capture;
+                continue;
+            }
+            *move = capture;
+            return 1;
+        }
+        // Quiescence search prunes SEE-losing captures altogether
+        if (mp->captures_only) {
+            mp->stage = STAGE_DONE;
+            return 0;
+        }
+        mp->stage = STAGE_KILLER_1;
+        /* fall through */
+
+    case STAGE_KILLER_1:
+    case STAGE_KILLER_2:
+        while (mp->stage <= STAGE_KILLER_2 && !mp->skip_quiets) {
+            int slot = mp->stage - STAGE_KILLER_1;
+            Move killer = mp->killers[slot];
+            mp->stage++;
+            if (killer.from == killer.to || is_tt_move(mp, killer)) continue;
+            if (slot == 1 && same_move(killer, mp->killers[0])) continue;
+            if (unpack_move(board, pack_move(killer), move) && !move->is_capture) {
+                return 1;
+            }
+        }
+        /* fall through */
+
+    case STAGE_COUNTER_MOVE: {
+        mp->stage = STAGE_INIT_QUIETS;
+        Move counter = mp->counter_move;
+        if (!mp->skip_quiets && is_move(counter) && !is_tt_move(mp, counter) && !is_killer(mp, counter)
+            && unpack_move(board, pack_move(counter), move) && !move->is_capture) {
+            return 1;
+        }
+    }
+        /* fall through */
+
+    case STAGE_INIT_QUIETS: {
+        if (mp->skip_quiets) {
+            mp->current = 0;
+            mp->stage = STAGE_BAD_CAPTURES;
+            return next_move(mp, move);
+        }
+        int side = board->side_to_move;
+        int first_quiet = mp->list.count;
+        generate_all_quiets(board, &mp->list);
+        for (int i = first_quiet; i < mp->list.count; i++) {
+            Move* quiet = &mp->list.moves[i];
+            quiet->score = quiet_history(mp->ctx, side, *quiet, mp->previous);
+            // Queen push-promotions are tactical; put them ahead of other quiets
+            if (quiet->promotion == Q || quiet->promotion == q) quiet->score += 4 * MAX_HISTORY;
+        }
+        mp->current = first_quiet;
+        mp->end = mp->list.count;
+        mp->stage = STAGE_QUIETS;
+    }
+        /* fall through */
+
+    case STAGE_QUIETS:
+        while (mp->current < mp->end && !mp->skip_quiets) {
+            Move quiet = pick_best(mp);
+            if (is_tt_move(mp, quiet) || is_killer(mp, quiet) || is_counter_move(mp, quiet)) continue;
+            *move = quiet;
+            return 1;
+        }
+        mp->current = 0;
+        mp->stage = STAGE_BAD_CAPTURES;
+        /* fall through */
+
+    case STAGE_BAD_CAPTURES:
+        // Already in MVV-LVA order since they were set aside as they were picked
+        if (mp->current < mp->bad_count) {
+            *move = mp->list.moves[mp->current++];
+            return 1;
+        }
+        mp->stage = STAGE_DONE;
+        /* fall through */
+
+    default:
+        return 0;
+    }
+}
+
+// --- Pruning Parameters ---
+// Depth limits and margins (in centipawns) for the forward pruning in negamax.
+// Kept in a struct so they can be tuned without recompiling.
+SearchParams search_params = {
+    .rfp_depth = 8,      .rfp_margin = 100,
+    .razor_depth = 3,    .razor_margin = 300,
+    .futility_depth = 6, .futility_base = 150, .futility_margin = 120,
+    .lmp_depth = 6,      .lmp_base = 3,
+    .singular_depth = 6, .singular_margin = 2,
+    .iir_depth = 4,      .use_iid = 0,
+    .null_min_depth = 3, .null_base_reduction = 3, .null_depth_divisor = 4, .null_eval_divisor = 200,
+    .null_verify_depth = 12,
+};
+
+// Knights, bishops, rooks or queens for the side to move. Without them
+// zugzwang is common and passing is not a safe lower bound.
+static int has_non_pawn_material(const Board* board) {
+    if (board->side_to_move == WHITE) {
+        return (board->piece_bitboards[N] | board->piece_bitboards[B] | board->piece_bitboards[R] | board->piece_bitboards[Q]) != 0;
+    }
+    return (board->piece_bitboards[n] | board->piece_bitboards[b] | board->piece_bitboards[r] | board->piece_bitboards[q]) != 0;
+}
+
+// --- Late Move Reductions ---
+// reductions[depth][move_number] grows with the log of both, so late moves at
+// high depth are reduced the most. Filled in by init_search().
+static int reductions[MAX_PLY][MAX_MOVES];
+
+void init_search() {
+    for (int depth = 1; depth < MAX_PLY; depth++) {
+        for (int move_number = 1; move_number < MAX_MOVES; move_number++) {
+            reductions[depth][move_number] = (int)(0.75 + log(depth) * log(move_number) / 2.25);
+        }
+    }
+}
+
+// --- Time Management ---
+// The search polls the clock and node counter every CHECK_INTERVAL nodes and
+// raises the context's stop flag once a hard limit is hit. All scores returned after
+// that point are garbage and must not be stored or used.
+#define CHECK_INTERVAL 2048
+#define MOVE_OVERHEAD 50 // ms kept in reserve for communication lag
+
+long long get_time_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Splits the remaining clock into a soft target for this move and a hard cap
+// that the search may stretch to when the position is unclear.
+static void allocate_time(SearchContext* ctx, const SearchLimits* limits, int side) {
+    int time_left = (side == WHITE) ? limits->wtime : limits->btime;
+    int increment = (side == WHITE) ? limits->winc : limits->binc;
+
+    ctx->soft_time_limit = ctx->hard_time_limit = 0;
+    if (limits->infinite) return;
+
+    if (limits->movetime > 0) {
+        // A fixed move time is meant to be used in full: no soft target, so
+        // stability and score-drop scaling never end the search early
+        ctx->hard_time_limit = limits->movetime;
+    } else if (time_left > 0) {
+        int moves_to_go = limits->movestogo > 0 ? limits->movestogo : 30;
+        if (moves_to_go > 40) moves_to_go = 40;
+
+        long long max_time = time_left - MOVE_OVERHEAD;
+        if (max_time < 1) max_time = 1;
+
+        ctx->soft_time_limit = time_left / moves_to_go + increment * 3 / 4;
+        ctx->hard_time_limit = ctx->soft_time_limit * 4;
+        if (ctx->hard_time_limit > max_time) ctx->hard_time_limit = max_time;
+        if (ctx->soft_time_limit > ctx->hard_time_limit) ctx->soft_time_limit = ctx->hard_time_limit;
+    }
+}
+
+// --- Pondering ---
+// A ponder search runs without time limits on the position after the
+// expected reply. On a ponderhit the limits it was started with come into
+// force from that moment on, and the same search carries on as a normal
+// timed one; on a miss the caller simply stops it.
+// ponderhit_context() runs on the caller's thread, so it only records the
+// time and raises a flag; the search thread sets its own clock and limits
+// when it next polls them.
+void ponderhit_context(SearchContext* ctx) {
+    pthread_mutex_lock(&ctx->ponder_lock);
+    ctx->ponderhit_time = get_time_ms();
+    atomic_store_explicit(&ctx->ponderhit_pending, 1, memory_order_release);
+    pthread_cond_signal(&ctx->ponder_cond);
+    pthread_mutex_unlock(&ctx->ponder_lock);
+}
+
+// Search thread: ends pondering once a ponderhit has arrived
+static void accept_ponderhit(SearchContext* ctx) {
+    if (!ctx->pondering || !atomic_load_explicit(&ctx->ponderhit_pending, memory_order_acquire)) return;
+    ctx->clock_start_time = ctx->ponderhit_time;
+    allocate_time(ctx, &ctx->limits, ctx->root_side);
+    ctx->pondering = 0;
+}
+
+static void check_limits(SearchContext* ctx) {
+    accept_ponderhit(ctx);
+    if (ctx->pondering) return;
+    if (ctx->hard_time_limit && get_time_ms() - ctx->clock_start_time >= ctx->hard_time_limit) {
+        ctx->stopped = 1;
+    }
+    if (ctx->node_limit && ctx->nodes >= ctx->node_limit) {
+        ctx->stopped = 1;
+    }
+}
+
+// --- Mate Scores ---
+// Mate scores count plies from the root, but the same position can be
+// reached at another ply through a transposition. The TT stores mates as
+// the distance from the position itself and converts back when probed.
+static int score_to_tt(int score, int ply) {
+    if (score > MATE_SCORE - MAX_PLY) return score + ply;
+    if (score < -MATE_SCORE + MAX_PLY) return score - ply;
+    return score;
+}
+
+static int score_from_tt(int score, int ply) {
+    if (score > MATE_SCORE - MAX_PLY) return score - ply;
+    if (score < -MATE_SCORE + MAX_PLY) return score + ply;
+    return score;
+}
+
+static int quiescence_search(SearchContext* ctx, Board* board, int alpha, int beta) {
+    if ((++ctx->nodes & (CHECK_INTERVAL - 1)) == 0) check_limits(ctx);
+    if (ctx->stopped) return 0;
+    ctx->stats.qnodes++;
+
+    int ply = search_ply(ctx, board);
+    if (ply > ctx->stats.seldepth) ctx->stats.seldepth = ply;
+    if (ply >= MAX_PLY - 1) return evaluate(board);
+
+    // Quiescence results are stored at depth 0, so any entry can cut here
+    HashEntry tt_entry;
+    int tt_hit = probe_hash_entry(&ctx->tt, board->hash_key, &tt_entry);
+    if (tt_hit) tt_entry.score = score_from_tt(tt_entry.score, ply);
+    int tt_move = tt_hit ? tt_entry.best_move : 0;
+    int score = tt_hit ? hash_entry_score(&tt_entry, 0, alpha, beta) : NO_HASH_ENTRY;
+    ctx->stats.tt_probes++;
+    ctx->stats.tt_hits += tt_hit;
+    if (score != NO_HASH_ENTRY) {
+        ctx->stats.tt_cutoffs++;
+        return score;
+    }
 
     int original_side = board->side_to_move;
-    for (int i = 0; i < move_list.count; i++) {
-        Move move = move_list.moves[i];
-        if (!move.is_capture) continue;
+    u64 king_bb = board->piece_bitboards[original_side == WHITE ? K : k];
+    int in_check = king_bb != 0 && is_square_attacked(__builtin_ctzll(king_bb), !original_side, board);
+
+    // Standing pat is only valid if we could also decline to capture; in
+    // check every evasion has to be searched instead. Only the side of the
+    // window the stand-pat score falls on matters, so the full evaluation is
+    // skipped when material is far outside it; that estimate isn't a real
+    // static eval and isn't stored as one.
+    int static_eval = NO_HASH_ENTRY;
+    int stored_eval = NO_HASH_ENTRY;
+    int original_alpha = alpha;
+    if (!in_check) {
+        if (tt_hit && tt_entry.static_eval != NO_HASH_ENTRY) {
+            static_eval = stored_eval = tt_entry.static_eval;
+        } else {
+            int early_exit;
+            static_eval = evaluate_lazy(board, alpha, beta, &early_exit);
+            if (!early_exit) stored_eval = static_eval;
+            ctx->stats.lazy_evals++;
+            ctx->stats.lazy_exits += early_exit;
+        }
+
+        if (static_eval >= beta) {
+            record_hash(&ctx->tt, board->hash_key, 0, score_to_tt(beta, ply), HASH_FLAG_BETA, 0, stored_eval);
+            return beta;
+        }
+        if (static_eval > alpha) alpha = static_eval;
+    }
+
+    MovePicker picker;
+    init_move_picker(ctx, &picker, board, tt_move, !in_check);
+
+    int moves_made = 0;
+    Move move;
+    Move best_move = {0};
+    while (next_move(&picker, &move)) {
+        // --- Delta Pruning ---
+        // Even winning the captured piece for free can't lift us to alpha
+        if (!in_check && !move.promotion) {
+            int victim = move.is_enpassant ? P : get_piece_on_square(board, move.to);
+            if (victim != -1 && static_eval + material_score[victim].eg + DELTA_MARGIN <= alpha) continue;
+        }
 
         make_move(board, move);
-        u64 king_bb = board->piece_bitboards[original_side == WHITE ? K : k];
-        if (king_bb != 0) {
-            int king_square = __builtin_ctzll(king_bb);
+        prefetch_hash(&ctx->tt, board->hash_key);
+        u64 current_king_bb = board->piece_bitboards[original_side == WHITE ? K : k];
+        if (current_king_bb != 0) {
+            int king_square = __builtin_ctzll(current_king_bb);
             if (!is_square_attacked(king_square, !original_side, board)) {
-                int score = -quiescence_search(board, -beta, -alpha);
+                moves_made++;
+                ctx->stack[ply].current_move = move;
+                score = -quiescence_search(ctx, board, -beta, -alpha);
+                if (ctx->stopped) {
+                    unmake_move(board, move);
+                    return 0;
+                }
                 if (score >= beta) {
                     unmake_move(board, move);
+                    record_hash(&ctx->tt, board->hash_key, 0, score_to_tt(beta, ply), HASH_FLAG_BETA, pack_move(move), stored_eval);
                     return beta;
                 }
-                if (score > alpha) alpha = score;
+                if (score > alpha) {
+                    alpha = score;
+                    best_move = move;
+                }
             }
         }
         unmake_move(board, move);
     }
+
+    // No legal evasion: checkmate
+    if (in_check && moves_made == 0) {
+        return -MATE_SCORE + ply;
+    }
+
+    int hash_flag = alpha > original_alpha ? HASH_FLAG_EXACT : HASH_FLAG_ALPHA;
+    record_hash(&ctx->tt, board->hash_key, 0, score_to_tt(alpha, ply), hash_flag, hash_flag == HASH_FLAG_EXACT ? pack_move(best_move) : 0, stored_eval);
     return alpha;
 }
 
 
-static int negamax(Board* board, int depth, int alpha, int beta, int is_null) {
+// --- Legal Moves ---
+static int is_legal_move(Board* board, Move move) {
+    int side = board->side_to_move;
+    make_move(board, move);
+    u64 king_bb = board->piece_bitboards[side == WHITE ? K : k];
+    int legal = king_bb && !is_square_attacked(__builtin_ctzll(king_bb), !side, board);
+    unmake_move(board, move);
+    return legal;
+}
+
+static int generate_legal_moves(Board* board, MoveList* legal_moves) {
+    MoveList move_list;
+    generate_all_moves(board, &move_list);
+    legal_moves->count = 0;
+    for (int i = 0; i < move_list.count; i++) {
+        if (is_legal_move(board, move_list.moves[i])) {
+            legal_moves->moves[legal_moves->count++] = move_list.moves[i];
+        }
+    }
+    return legal_moves->count;
+}
+
+
+static int negamax(SearchContext* ctx, Board* board, int depth, int alpha, int beta, int is_null) {
     int hash_flag = HASH_FLAG_ALPHA;
-    int score = probe_hash(board->hash_key, depth, alpha, beta);
-    if (score != NO_HASH_ENTRY && !is_null) {
-        return score;
+    int tt_move = 0;
+    int ply = search_ply(ctx, board);
+
+    // --- Draw Detection ---
+    // Repetitions and fifty-move draws are scored immediately instead of being
+    // searched (and filling the TT with shuffle lines). Never at the root,
+    // which must return a move. Mate on the hundredth half-move still counts
+    // as mate, so a side in check needs a legal move for the fifty-move draw.
+    if (ply > 0 && is_fifty_move_draw(board)) {
+        u64 king_bb = board->piece_bitboards[board->side_to_move == WHITE ? K : k];
+        MoveList legal_moves;
+        if (king_bb && is_square_attacked(__builtin_ctzll(king_bb), !board->side_to_move, board)
+            && generate_legal_moves(board, &legal_moves) == 0) {
+            return -MATE_SCORE + ply;
+        }
+        return 0;
+    }
+    if (ply > 0 && is_repetition(board, ctx->root_ply)) {
+        return 0;
+    }
+    if (ply >= MAX_PLY - 1) {
+        return evaluate(board);
     }
 
-    if (depth == 0) {
-        return quiescence_search(board, alpha, beta);
+    // --- Mate Distance Pruning ---
+    // Neither side can do better than mating right here or worse than being
+    // mated right here; once a shorter mate is known the window closes.
+    if (ply > 0) {
+        if (alpha < -MATE_SCORE + ply) alpha = -MATE_SCORE + ply;
+        if (beta > MATE_SCORE - ply - 1) beta = MATE_SCORE - ply - 1;
+        if (alpha >= beta) return alpha;
     }
 
-    // --- Safe Null-Move Pruning ---
+    // The position hash is the same while a move is excluded, so the TT
+    // score belongs to a different search and must not cut this one off
+    int excluded = ply < MAX_PLY && ctx->stack[ply].excluded_move.from != ctx->stack[ply].excluded_move.to;
+    if (depth <= 0) {
+        return quiescence_search(ctx, board, alpha, beta);
+    }
+
+    HashEntry tt_entry;
+    int tt_hit = probe_hash_entry(&ctx->tt, board->hash_key, &tt_entry);
+    if (tt_hit) tt_entry.score = score_from_tt(tt_entry.score, ply);
+    int score = tt_hit ? hash_entry_score(&tt_entry, depth, alpha, beta) : NO_HASH_ENTRY;
+    if (tt_hit) tt_move = tt_entry.best_move;
+    ctx->stats.tt_probes++;
+    ctx->stats.tt_hits += tt_hit;
+    if (score != NO_HASH_ENTRY && !is_null && !excluded) {
+        ctx->stats.tt_cutoffs++;
+        return score;
+    }
+
+    if ((++ctx->nodes & (CHECK_INTERVAL - 1)) == 0) check_limits(ctx);
+    if (ctx->stopped) return 0;
+    if (ply > ctx->stats.seldepth) ctx->stats.seldepth = ply;
+
     u64 king_bb = board->piece_bitboards[board->side_to_move == WHITE ? K : k];
-    if (!is_null && king_bb != 0) {
-        int king_sq = __builtin_ctzll(king_bb);
-        if (!is_square_attacked(king_sq, !board->side_to_move, board)) {
-            // Manually update board state for the null move
-            int original_ep_square = board->enpassant_square;
-            board->ply++;
-            board->side_to_move = !board->side_to_move;
-            board->hash_key ^= side_key;
-            if (board->enpassant_square != -1) {
-                board->hash_key ^= enpassant_keys[board->enpassant_square];
+    int in_check = king_bb != 0 && is_square_attacked(__builtin_ctzll(king_bb), !board->side_to_move, board);
+    int pv_node = beta - alpha > 1;
+    int static_eval = -INFINITE_SCORE;
+    if (!in_check) {
+        static_eval = (tt_hit && tt_entry.static_eval != NO_HASH_ENTRY) ? tt_entry.static_eval : evaluate(board);
+    }
+    int stored_eval = in_check ? NO_HASH_ENTRY : static_eval;
+
+    if (ply < MAX_PLY) ctx->stack[ply].static_eval = static_eval;
+    // Positions where we're better than two plies ago deserve less pruning
+    int improving = !in_check && (ply < 2 || ply >= MAX_PLY || static_eval > ctx->stack[ply - 2].static_eval);
+
+    // Forward pruning is only sound-ish outside PV nodes and out of check, and
+    // never when mate scores are in play
+    int can_prune = !pv_node && !in_check && beta < MATE_SCORE - MAX_PLY && alpha > -MATE_SCORE + MAX_PLY;
+
+    // --- Reverse Futility Pruning (Static Null Move) ---
+    // Far enough above beta that a quiet move is very unlikely to drop below it.
+    if (can_prune && depth <= search_params.rfp_depth && static_eval - search_params.rfp_margin * depth >= beta) {
+        return static_eval;
+    }
+
+    // --- Razoring ---
+    // Hopelessly below alpha near the leaves: verify with a quiescence search.
+    if (can_prune && depth <= search_params.razor_depth && static_eval + search_params.razor_margin * depth < alpha) {
+        score = quiescence_search(ctx, board, alpha, beta);
+        if (ctx->stopped) return 0;
+        if (score <= alpha) return score;
+    }
+
+    // --- Null-Move Pruning ---
+    // If passing still leaves us above beta, a real move almost surely would.
+    // The reduction grows with depth and with how far the eval is above beta.
+    // Zugzwang breaks that assumption, so only try it when the side to move
+    // has a piece, and verify deep cutoffs with a reduced normal search.
+    if (can_prune && !is_null && !excluded && king_bb != 0 && depth >= search_params.null_min_depth
+        && static_eval >= beta && has_non_pawn_material(board)) {
+        int eval_reduction = (static_eval - beta) / search_params.null_eval_divisor;
+        if (eval_reduction > 3) eval_reduction = 3;
+        int null_depth = depth - 1 - search_params.null_base_reduction - depth / search_params.null_depth_divisor - eval_reduction;
+        // Always leave a ply of real search: dropping straight into quiescence
+        // would miss threats such as a quiet move that traps a piece
+        if (null_depth < 1) null_depth = 1;
+
+        ctx->stack[ply].current_move = (Move){0};
+        make_null_move(board);
+        score = -negamax(ctx, board, null_depth, -beta, -beta + 1, 1);
+        unmake_null_move(board);
+        ctx->stats.null_tries++;
+
+        if (ctx->stopped) return 0;
+        if (score >= beta) {
+            // Passing proves nothing about mates, so don't return one
+            if (score >= MATE_SCORE - MAX_PLY) score = beta;
+            if (depth < search_params.null_verify_depth) {
+                ctx->stats.null_cutoffs++;
+                return score;
             }
-            board->enpassant_square = -1;
-            
-            score = -negamax(board, depth - 1 - 2, -beta, -beta + 1, 1);
-            
-            // Manually restore the board state
-            board->ply--;
-            board->side_to_move = !board->side_to_move;
-            board->hash_key ^= side_key;
-            board->enpassant_square = original_ep_square;
-             if (board->enpassant_square != -1) {
-                board->hash_key ^= enpassant_keys[board->enpassant_square];
+            // Same node, same window, but without the null move at the top
+            int verify_score = negamax(ctx, board, null_depth + 1, beta - 1, beta, 1);
+            if (ctx->stopped) return 0;
+            if (verify_score >= beta) {
+                ctx->stats.null_cutoffs++;
+                return score;
             }
+        }
+    }
 
-            if (score >= beta) {
-                return beta;
+    // --- Internal Iterative Reductions ---
+    // Without a TT move this node will be badly ordered. Searching it one ply
+    // shallower is cheap, and stores a move for the next iteration to use.
+    // IID instead spends a reduced search up front just to find that move.
+    if (tt_move == 0 && !excluded && depth >= search_params.iir_depth) {
+        if (search_params.use_iid) {
+            if (pv_node) {
+                negamax(ctx, board, depth - 2, alpha, beta, 0);
+                if (ctx->stopped) return 0;
+                HashEntry iid_entry;
+                if (probe_hash_entry(&ctx->tt, board->hash_key, &iid_entry)) tt_move = iid_entry.best_move;
             }
+        } else {
+            depth--;
         }
     }
 
-    MoveList move_list;
-    generate_all_moves(board, &move_list);
-    score_moves(board, &move_list);
+    MovePicker picker;
+    init_move_picker(ctx, &picker, board, tt_move, 0);
 
     int moves_made = 0;
-    int best_score = -INFINITY;
+    int best_score = -INFINITE_SCORE;
     int original_side = board->side_to_move;
+    Move quiets_tried[MAX_MOVES];
+    int quiet_count = 0;
+    Move move;
+    Move best_move = {0};
 
-    for (int i = 0; i < move_list.count; i++) {
-        make_move(board, move_list.moves[i]);
+    // Quiet moves near the leaves can't make up the deficit to alpha
+    int futile = can_prune && depth <= search_params.futility_depth
+              && static_eval + search_params.futility_base + search_params.futility_margin * depth <= alpha;
+
+    // A TT move that is much better than every alternative is "singular" and
+    // gets extended. Only worth testing when the TT has a reliable lower bound.
+    int singular_candidate = depth >= search_params.singular_depth && !excluded && ply > 0 && tt_hit
+                          && tt_entry.best_move != 0 && tt_entry.flags != HASH_FLAG_ALPHA
+                          && tt_entry.depth >= depth - 3
+                          && tt_entry.score > -MATE_SCORE + MAX_PLY && tt_entry.score < MATE_SCORE - MAX_PLY;
+    int can_extend = ply < 2 * ctx->root_depth && ply < MAX_PLY - 1;
+
+    while (next_move(&picker, &move)) {
+        int is_quiet = !move.is_capture && !move.promotion;
+        if (excluded && same_move(move, ctx->stack[ply].excluded_move)) continue;
+
+        // --- Singular Extension ---
+        // Search every other move at reduced depth against a bound just below
+        // the TT score; if none reaches it, the TT move is the only good one.
+        int extension = 0;
+        if (singular_candidate && can_extend && pack_move(move) == tt_entry.best_move) {
+            int singular_beta = tt_entry.score - search_params.singular_margin * depth;
+
+            ctx->stack[ply].excluded_move = move;
+            score = negamax(ctx, board, (depth - 1) / 2, singular_beta - 1, singular_beta, 0);
+            ctx->stack[ply].excluded_move = (Move){0};
+            if (ctx->stopped) return 0;
+
+            if (score < singular_beta) {
+                extension = 1;
+            } else if (singular_beta >= beta) {
+                // Multi-cut: even without the TT move another move beats beta
+                return singular_beta;
+            }
+        }
+
+        // --- Late Move Pruning ---
+        // Late quiets at shallow depth almost never cut; stop generating them.
+        if (can_prune && is_quiet && depth <= search_params.lmp_depth
+            && moves_made >= search_params.lmp_base + depth * depth) {
+            picker.skip_quiets = 1;
+            continue;
+        }
+
+        make_move(board, move);
+        prefetch_hash(&ctx->tt, board->hash_key);
         u64 current_king_bb = board->piece_bitboards[original_side == WHITE ? K : k];
         if (current_king_bb != 0) {
             int king_sq = __builtin_ctzll(current_king_bb);
             if (!is_square_attacked(king_sq, !original_side, board)) {
+                u64 enemy_king_bb = board->piece_bitboards[original_side == WHITE ? k : K];
+                int gives_check = enemy_king_bb && is_square_attacked(__builtin_ctzll(enemy_king_bb), original_side, board);
+
+                // --- Futility Pruning ---
+                // Skip quiet moves that don't give check, once one move has been searched.
+                if (futile && is_quiet && !gives_check && best_score > -INFINITE_SCORE) {
+                    unmake_move(board, move);
+                    continue;
+                }
+
+                // Only searched moves count towards the LMR and LMP move numbers
                 moves_made++;
-                if (moves_made > 4 && depth > 2 && !move_list.moves[i].is_capture) {
-                    score = -negamax(board, depth - 2, -alpha -1, -alpha, 0);
+                ctx->stack[ply].current_move = move;
+
+                // --- Check Extension ---
+                if (gives_check && can_extend) extension = 1;
+                int new_depth = depth - 1 + extension;
+
+                if (moves_made == 1) {
+                    score = -negamax(ctx, board, new_depth, -beta, -alpha, 0);
                 } else {
-                    score = -negamax(board, depth - 1, -alpha -1, -alpha, 0);
+                    // --- Late Move Reductions ---
+                    int reduction = 0;
+                    if (depth >= 3 && is_quiet && !gives_check && moves_made > (pv_node ? 2 : 1)) {
+                        reduction = reductions[depth < MAX_PLY ? depth : MAX_PLY - 1][moves_made < MAX_MOVES ? moves_made : MAX_MOVES - 1];
+                        if (pv_node) reduction--;
+                        if (!improving) reduction++;
+                        reduction -= quiet_history(ctx, original_side, move, picker.previous) / 5000;
+
+                        if (reduction > new_depth - 1) reduction = new_depth - 1;
+                        if (reduction < 0) reduction = 0;
+                    }
+
+                    score = -negamax(ctx, board, new_depth - reduction, -alpha - 1, -alpha, 0);
+                    if (reduction > 0) ctx->stats.lmr_searches++;
+
+                    // A reduced move that beats alpha has to prove it at full depth
+                    if (reduction > 0 && score > alpha) {
+                        ctx->stats.lmr_researches++;
+                        score = -negamax(ctx, board, new_depth, -alpha - 1, -alpha, 0);
+                    }
+                    if (score > alpha && score < beta) {
+                        score = -negamax(ctx, board, new_depth, -beta, -alpha, 0);
+                    }
                 }
 
-                if (score > alpha && score < beta) {
-                     score = -negamax(board, depth - 1, -beta, -alpha, 0);
+                if (ctx->stopped) {
+                    unmake_move(board, move);
+                    return 0;
                 }
 
                 if (score > best_score) {
                     best_score = score;
+                    best_move = move;
                     if (best_score > alpha) {
                         alpha = best_score;
                         hash_flag = HASH_FLAG_EXACT;
                         if (alpha >= beta) {
-                            unmake_move(board, move_list.moves[i]);
-                            record_hash(board->hash_key, depth, beta, HASH_FLAG_BETA);
+                            unmake_move(board, move);
+                            ctx->stats.beta_cutoffs++;
+                            if (moves_made == 1) ctx->stats.first_move_cutoffs++;
+                            if (!move.is_capture) {
+                                update_quiet_heuristics(ctx, board, move, quiets_tried, quiet_count, depth);
+                            }
+                            if (!excluded) record_hash(&ctx->tt, board->hash_key, depth, score_to_tt(beta, ply), HASH_FLAG_BETA, pack_move(move), stored_eval);
                             return beta;
                         }
                     }
                 }
+
+                if (!move.is_capture) {
+                    quiets_tried[quiet_count++] = move;
+                }
             }
         }
-        unmake_move(board, move_list.moves[i]);
+        unmake_move(board, move);
     }
 
     if (moves_made == 0) {
+        // Only the excluded move was legal: it is trivially singular
+        if (excluded) return alpha;
         int king_sq_final = __builtin_ctzll(board->piece_bitboards[original_side == WHITE ? K : k]);
         if (is_square_attacked(king_sq_final, !original_side, board)) {
-            return -MATE_SCORE + board->ply;
+            return -MATE_SCORE + ply;
         } else {
             return 0;
         }
     }
 
-    record_hash(board->hash_key, depth, best_score, hash_flag);
+    if (!excluded) {
+        record_hash(&ctx->tt, board->hash_key, depth, score_to_tt(best_score, ply), hash_flag, hash_flag == HASH_FLAG_EXACT ? pack_move(best_move) : 0, stored_eval);
+    }
 
     return best_score;
 }
 
-Move search_position(Board* board, int depth) {
-    Move best_move = {0};
-    int best_score = -INFINITY;
-    int original_side = board->side_to_move;
+// --- Root Search ---
+// Moves already reported by earlier MultiPV slots in this iteration; the
+// root search skips them so each pass finds the next best move.
+static int is_root_excluded(SearchContext* ctx, Move move) {
+    for (int i = 0; i < ctx->root_excluded_count; i++) {
+        if (same_move(move, ctx->root_excluded[i])) return 1;
+    }
+    return 0;
+}
 
-    // Aspiration Windows
-    int alpha = -INFINITY, beta = INFINITY;
-    int delta = 25;
+// Searches every legal root move and reports the best one through
+// 'best_move'. Mirrors negamax, but never returns early so the caller always
+// gets a move, and returns without touching 'best_move' if stopped.
+static int search_root(SearchContext* ctx, Board* board, int depth, int alpha, int beta, Move* best_move) {
+    int tt_move = 0;
+    probe_hash(&ctx->tt, board->hash_key, depth, alpha, beta, &tt_move);
 
-    for (int current_depth = 1; current_depth <= depth; ++current_depth) {
-        best_score = negamax(board, current_depth, alpha, beta, 0);
+    MovePicker picker;
+    init_move_picker(ctx, &picker, board, tt_move, 0);
 
-        if (best_score <= alpha || best_score >= beta) {
-            alpha = -INFINITY;
-            beta = INFINITY;
-            best_score = negamax(board, current_depth, alpha, beta, 0);
-        }
+    int original_side = board->side_to_move;
+    int original_alpha = alpha;
+    int best_score = -INFINITE_SCORE;
+    int moves_made = 0;
+    Move root_best = {0};
+    Move move;
 
-        alpha = best_score - delta;
-        beta = best_score + delta;
-        
-        MoveList move_list;
-        generate_all_moves(board, &move_list);
-        score_moves(board, &move_list);
+    while (next_move(&picker, &move)) {
+        if (ctx->root_excluded_count && is_root_excluded(ctx, move)) continue;
 
-        printf("info string searching depth %d\n", current_depth);
-        for (int i = 0; i < move_list.count; i++) {
-            Move current_move = move_list.moves[i];
-            make_move(board, current_move);
+        make_move(board, move);
+        prefetch_hash(&ctx->tt, board->hash_key);
+        u64 king_bb = board->piece_bitboards[original_side == WHITE ? K : k];
+        if (king_bb == 0 || is_square_attacked(__builtin_ctzll(king_bb), !original_side, board)) {
+            unmake_move(board, move);
+            continue;
+        }
 
-            u64 king_bb = board->piece_bitboards[original_side == WHITE ? K : k];
-            if (king_bb == 0) {
-                unmake_move(board, current_move);
+        // Check extension, as in negamax
+        u64 enemy_king_bb = board->piece_bitboards[original_side == WHITE ? k : K];
+        int gives_check = enemy_king_bb && is_square_attacked(__builtin_ctzll(enemy_king_bb), original_side, board);
+        int new_depth = depth - 1 + gives_check;
 
-                continue;
+        int score;
+        moves_made++;
+        ctx->stack[0].current_move = move;
+        if (moves_made == 1) {
+            score = -negamax(ctx, board, new_depth, -beta, -alpha, 0);
+        } else {
+            score = -negamax(ctx, board, new_depth, -alpha - 1, -alpha, 0);
+            if (score > alpha && score < beta) {
+                score = -negamax(ctx, board, new_depth, -beta, -alpha, 0);
             }
-            int king_square = __builtin_ctzll(king_bb);
-            if (is_square_attacked(king_square, !original_side, board)) {
-                unmake_move(board, current_move);
+        }
+        unmake_move(board, move);
 
-                continue;
+        if (ctx->stopped) return 0;
+
+        if (score > best_score) {
+            best_score = score;
+            root_best = move;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) break;
             }
+        }
+    }
 
-            int score = -negamax(board, current_depth - 1, -INFINITY, INFINITY, 0);
-            unmake_move(board, current_move);
+    if (moves_made == 0) {
+        int king_sq = __builtin_ctzll(board->piece_bitboards[original_side == WHITE ? K : k]);
+        return is_square_attacked(king_sq, !original_side, board) ? -MATE_SCORE + search_ply(ctx, board) : 0;
+    }
 
-            if (score > best_score) {
-                best_score = score;
-                best_move = current_move;
-                char san_move[16];
+    // With moves excluded the result isn't the root's true score, so it must
+    // not overwrite the entry the first MultiPV pass stored
+    if (ctx->root_excluded_count == 0) {
+        int hash_flag = best_score >= beta ? HASH_FLAG_BETA : best_score > original_alpha ? HASH_FLAG_EXACT : HASH_FLAG_ALPHA;
+        record_hash(&ctx->tt, board->hash_key, depth, best_score, hash_flag, pack_move(root_best), NO_HASH_ENTRY);
+    }
+    *best_move = root_best;
+    return best_score;
+}
+
+// --- Aspiration Windows ---
+// Searches the root with a narrow window around the previous iteration's
+// score. When the result falls outside, only the failing side is widened,
+// by a delta that grows 1.5x per failure, until the score fits.
+#define ASPIRATION_MIN_DEPTH 4
+#define ASPIRATION_MAX_DELTA 1000
+
+static int aspiration_search(SearchContext* ctx, Board* board, int depth, int previous_score, Move* best_move) {
+    int alpha = -INFINITE_SCORE, beta = INFINITE_SCORE;
+    // Early iterations are too unstable for a narrow window; deeper ones
+    // settle down, so they start tighter
+    int delta = 15 + 50 / depth;
+
+    if (depth >= ASPIRATION_MIN_DEPTH) {
+        alpha = previous_score - delta > -INFINITE_SCORE ? previous_score - delta : -INFINITE_SCORE;
+        beta = previous_score + delta < INFINITE_SCORE ? previous_score + delta : INFINITE_SCORE;
+    }
+
+    while (1) {
+        long nodes_before = ctx->nodes;
+        Move move = *best_move;
+        int score = search_root(ctx, board, depth, alpha, beta, &move);
+        if (ctx->stopped) return 0;
+
+        if (score <= alpha) {
+            // Fail low: keep the previous best move, pull beta in towards alpha
+            ctx->stats.aspiration_fail_lows++;
+            ctx->stats.aspiration_wasted_nodes += ctx->nodes - nodes_before;
+            beta = (alpha + beta) / 2;
+            alpha = score - delta > -INFINITE_SCORE ? score - delta : -INFINITE_SCORE;
+        } else if (score >= beta) {
+            // Fail high: the move that failed high is already an improvement
+            ctx->stats.aspiration_fail_highs++;
+            ctx->stats.aspiration_wasted_nodes += ctx->nodes - nodes_before;
+            *best_move = move;
+            beta = score + delta < INFINITE_SCORE ? score + delta : INFINITE_SCORE;
+        } else {
+            *best_move = move;
+            return score;
+        }
 
-                move_to_san(san_move, board, current_move);
-                printf("info score cp %d move %s\n", score, san_move);
+        delta += delta / 2;
+        if (delta > ASPIRATION_MAX_DELTA) {
+            alpha = -INFINITE_SCORE;
+            beta = INFINITE_SCORE;
+        }
+    }
+}
+
+// --- Statistics ---
+static double percent(long part, long total) {
+    return total ? 100.0 * part / total : 0.0;
+}
+
+// One 'info string' line of key=value pairs, meant for scripts comparing
+// two builds rather than for reading
+static void print_search_stats(SearchContext* ctx) {
+    const SearchStats* st = &ctx->stats;
+    // Effective branching factor: the b with b^depth = nodes of the completed iterations
+    double ebf = st->depth > 0 && st->completed_nodes > 0 ? pow((double)st->completed_nodes, 1.0 / st->depth) : 0.0;
+    if (!ctx->output) return;
+
+    fprintf(ctx->output, "info string stats depth=%d seldepth=%d nodes=%ld qnodes=%ld time=%lld nps=%lld"
+           " tt_probes=%ld tt_hit=%.1f%% tt_cut=%.1f%% null_tries=%ld null_cut=%.1f%%"
+           " cutoffs=%ld first_move_cut=%.1f%% lmr=%ld lmr_research=%.1f%% ebf=%.2f"
+           " asp_fail_low=%d asp_fail_high=%d asp_wasted=%ld lazy_evals=%ld lazy_exit=%.1f%%\n",
+           st->depth, st->seldepth, st->nodes, st->qnodes, st->time_ms, st->nodes * 1000 / (st->time_ms + 1),
+           st->tt_probes, percent(st->tt_hits, st->tt_probes), percent(st->tt_cutoffs, st->tt_probes),
+           st->null_tries, percent(st->null_cutoffs, st->null_tries),
+           st->beta_cutoffs, percent(st->first_move_cutoffs, st->beta_cutoffs),
+           st->lmr_searches, percent(st->lmr_researches, st->lmr_searches), ebf,
+           st->aspiration_fail_lows, st->aspiration_fail_highs, st->aspiration_wasted_nodes,
+           st->lazy_evals, percent(st->lazy_exits, st->lazy_evals));
+}
+
+// UCI score field: "cp <centipawns>", or "mate <moves>" once a forced mate
+// is known (negative when we are the side getting mated)
+static void format_score(int score, char* out, size_t size) {
+    if (score > MATE_SCORE - MAX_PLY) {
+        snprintf(out, size, "mate %d", (MATE_SCORE - score + 1) / 2);
+    } else if (score < -MATE_SCORE + MAX_PLY) {
+        snprintf(out, size, "mate %d", -(MATE_SCORE + score) / 2);
+    } else {
+        snprintf(out, size, "cp %d", score);
+    }
+}
+
+// --- Principal Variation ---
+// Writes the PV starting with first_move in SAN, following the TT's best
+// moves for up to max_length plies
+static void format_pv(SearchContext* ctx, Board* board, Move first_move, int max_length, char* out, size_t size) {
+    Move line[MAX_PLY];
+    int length = 0;
+    size_t used = 0;
+    out[0] = '\0';
+
+    Move move = first_move;
+    while (1) {
+        char san_move[16];
+        move_to_san(san_move, board, move);
+        int written = snprintf(out + used, size - used, "%s%s", length ? " " : "", san_move);
+        if (written < 0 || (size_t)written >= size - used) break;
+        used += written;
+
+        make_move(board, move);
+        line[length++] = move;
+        if (length >= max_length || length >= MAX_PLY) break;
+
+        // Stop at a repeated position rather than walking a TT cycle
+        if (is_repetition(board, board->ply - length)) break;
+
+        HashEntry entry;
+        if (!probe_hash_entry(&ctx->tt, board->hash_key, &entry) || !entry.best_move) break;
+        if (!unpack_move(board, entry.best_move, &move) || !is_legal_move(board, move)) break;
+    }
+
+    while (length > 0) {
+        unmake_move(board, line[--length]);
+    }
+}
+
+Move search_with_context(SearchContext* ctx, Board* board, const SearchLimits* limits) {
+    Move best_move = {0};
+    int best_score = -INFINITE_SCORE;
+    int max_depth = limits->depth > 0 && limits->depth < MAX_PLY ? limits->depth : MAX_PLY - 1;
+    // A mate in N needs 2N-1 plies; allow for reductions hiding it at first,
+    // but give up eventually when there is no mate to find
+    if (limits->mate > 0 && limits->depth <= 0 && 4 * limits->mate < max_depth) {
+        max_depth = 4 * limits->mate;
+    }
+
+    ctx->root_ply = board->ply;
+    ctx->start_time = ctx->clock_start_time = get_time_ms();
+    ctx->nodes = 0;
+    ctx->node_limit = limits->nodes;
+    ctx->stats = (SearchStats){0};
+    ctx->limits = *limits;
+    ctx->root_side = board->side_to_move;
+    ctx->pondering = limits->ponder;
+    ctx->soft_time_limit = ctx->hard_time_limit = 0;
+    if (!ctx->pondering) allocate_time(ctx, limits, ctx->root_side);
+
+    // Evaluate with the network if one is enabled (falls back to the
+    // classical evaluation if the accumulators can't be allocated)
+    if (nnue_enabled() && ctx->nnue == NULL) ctx->nnue = nnue_create_stack();
+    nnue_attach(board, nnue_enabled() ? ctx->nnue : NULL);
+
+    // MultiPV can't report more lines than there are legal moves
+    MoveList legal_moves;
+    int legal_count = generate_legal_moves(board, &legal_moves);
+    int multipv = limits->multipv > 1 ? limits->multipv : 1;
+    if (multipv > MAX_MULTIPV) multipv = MAX_MULTIPV;
+    if (multipv > legal_count) multipv = legal_count;
+    ctx->root_line_count = 0;
+
+    // Clock allocation feedback
+    int stable_iterations = 0;
+    int previous_score = 0;
+
+    age_heuristics(ctx);
+    new_hash_generation(&ctx->tt);
+
+    for (int current_depth = 1; current_depth <= max_depth && multipv > 0; ++current_depth) {
+        RootLine lines[MAX_MULTIPV];
+        ctx->root_depth = current_depth;
+        ctx->root_excluded_count = 0;
+
+        // One root search per slot, each excluding the moves reported above it.
+        // The passes share the TT, so later ones are mostly cheap lookups.
+        for (int pv_index = 0; pv_index < multipv; pv_index++) {
+            int has_previous = pv_index < ctx->root_line_count;
+            Move slot_move = has_previous ? ctx->root_lines[pv_index].move : best_move;
+            int previous_slot_score = has_previous ? ctx->root_lines[pv_index].score : -INFINITE_SCORE;
+            if (is_root_excluded(ctx, slot_move)) slot_move = (Move){0};
+
+            int score = aspiration_search(ctx, board, current_depth, previous_slot_score, &slot_move);
+            if (ctx->stopped) break;
+
+            lines[pv_index] = (RootLine){ slot_move, score };
+            ctx->root_excluded[ctx->root_excluded_count++] = slot_move;
+        }
+        ctx->root_excluded_count = 0;
+
+        // An unfinished iteration can't be trusted; keep the last completed one
+        if (ctx->stopped) break;
+
+        // Search instability can leave a later slot scoring above an earlier
+        // one; report them ranked (insertion sort keeps equal scores in order)
+        for (int i = 1; i < multipv; i++) {
+            RootLine line = lines[i];
+            int j = i;
+            while (j > 0 && lines[j - 1].score < line.score) {
+                lines[j] = lines[j - 1];
+                j--;
             }
+            lines[j] = line;
+        }
+
+        Move iteration_move = lines[0].move;
+        if (current_depth > 1) {
+            stable_iterations = same_move(iteration_move, best_move) ? stable_iterations + 1 : 0;
+        }
+        best_move = iteration_move;
+        best_score = lines[0].score;
+        for (int i = 0; i < multipv; i++) ctx->root_lines[i] = lines[i];
+        ctx->root_line_count = multipv;
+
+        ctx->stats.depth = current_depth;
+        ctx->stats.completed_nodes = ctx->nodes;
+
+        long long elapsed = get_time_ms() - ctx->start_time;
+        for (int i = 0; i < multipv && ctx->output; i++) {
+            char pv[1024];
+            char multipv_field[24] = "";
+            char score_field[24];
+            format_pv(ctx, board, ctx->root_lines[i].move, current_depth, pv, sizeof(pv));
+            format_score(ctx->root_lines[i].score, score_field, sizeof(score_field));
+            if (multipv > 1) snprintf(multipv_field, sizeof(multipv_field), " multipv %d", i + 1);
+            fprintf(ctx->output, "info depth %d seldepth %d%s score %s nodes %ld nps %lld hashfull %d time %lld pv %s\n",
+                   current_depth, ctx->stats.seldepth, multipv_field, score_field, ctx->nodes,
+                   ctx->nodes * 1000 / (elapsed + 1), hash_full(&ctx->tt), elapsed, pv);
         }
+
+        // Mate search: done as soon as a mate within the requested moves is proven
+        if (limits->mate > 0 && best_score >= MATE_SCORE - (2 * limits->mate - 1)) break;
+
+        accept_ponderhit(ctx);
+        if (ctx->soft_time_limit) {
+            // Spend more time while the best move keeps changing or the score
+            // is falling, and less once the choice has been stable for a while
+            int scale = 100;
+            if (current_depth > 1 && stable_iterations == 0) scale += 50;
+            else if (stable_iterations >= 4) scale -= 30;
+            if (current_depth > 1 && best_score < previous_score - 30) scale += 40;
+
+            if ((get_time_ms() - ctx->clock_start_time) * 100 >= ctx->soft_time_limit * scale) break;
+        }
+        previous_score = best_score;
+    }
+
+    // A ponder search must not return before the ponderhit or stop, even
+    // if it has run out of depth
+    pthread_mutex_lock(&ctx->ponder_lock);
+    while (ctx->pondering && !ctx->stopped && !atomic_load(&ctx->ponderhit_pending)) {
+        pthread_cond_wait(&ctx->ponder_cond, &ctx->ponder_lock);
+    }
+    // The signals are cleared here rather than when the next search starts,
+    // so a stop or ponderhit sent just after its thread is spawned isn't lost
+    ctx->stopped = 0;
+    atomic_store(&ctx->ponderhit_pending, 0);
+    pthread_mutex_unlock(&ctx->ponder_lock);
+    ctx->pondering = 0;
+    nnue_attach(board, NULL);
+
+    // Only reachable if stopped before depth 1 finished: take any legal move
+    if (best_move.from == best_move.to && legal_count > 0) {
+        best_move = legal_moves.moves[0];
+    }
+
+    ctx->stats.nodes = ctx->nodes;
+    ctx->stats.time_ms = get_time_ms() - ctx->start_time;
+    print_search_stats(ctx);
+
+    if (!ctx->output) return best_move;
+    if (best_move.from == best_move.to) {
+        fprintf(ctx->output, "bestmove (none)\n");
+        return best_move;
     }
-    
     char san_best_move[16];
     move_to_san(san_best_move, board, best_move);
-    printf("bestmove %s\n", san_best_move);
+    fprintf(ctx->output, "bestmove %s\n", san_best_move);
+    fflush(ctx->output);
     return best_move;
-}
\ No newline at end of file
+}
+
+int get_context_root_lines(const SearchContext* ctx, RootLine* lines, int max_lines) {
+    int count = ctx->root_line_count < max_lines ? ctx->root_line_count : max_lines;
+    for (int i = 0; i < count; i++) lines[i] = ctx->root_lines[i];
+    return count;
+}
+
+// Writes the PV of the best line of ctx's last search, in SAN, as far as
+// the TT still knows it. Returns 0 if that search produced no line.
+int get_context_pv(SearchContext* ctx, Board* board, char* out, size_t size) {
+    if (ctx->root_line_count == 0) {
+        if (size) out[0] = '\0';
+        return 0;
+    }
+    format_pv(ctx, board, ctx->root_lines[0].move, ctx->stats.depth, out, size);
+    return 1;
+}
+
+const SearchStats* get_context_stats(const SearchContext* ctx) {
+    return &ctx->stats;
+}
+
+void stop_search_context(SearchContext* ctx) {
+    pthread_mutex_lock(&ctx->ponder_lock);
+    ctx->stopped = 1;
+    pthread_cond_signal(&ctx->ponder_cond);
+    pthread_mutex_unlock(&ctx->ponder_lock);
+}
+
+void set_search_output(SearchContext* ctx, FILE* output) {
+    ctx->output = output;
+}
+
+SearchContext* create_search_context(int hash_mb) {
+    SearchContext* ctx = calloc(1, sizeof(SearchContext));
+    if (ctx == NULL) return NULL;
+    if (!init_transposition_table(&ctx->tt, hash_mb)) {
+        free(ctx);
+        return NULL;
+    }
+    pthread_mutex_init(&ctx->ponder_lock, NULL);
+    pthread_cond_init(&ctx->ponder_cond, NULL);
+    ctx->output = stdout;
+    return ctx;
+}
+
+void destroy_search_context(SearchContext* ctx) {
+    if (ctx == NULL) return;
+    free_transposition_table(&ctx->tt);
+    nnue_destroy_stack(ctx->nnue);
+    pthread_mutex_destroy(&ctx->ponder_lock);
+    pthread_cond_destroy(&ctx->ponder_cond);
+    free(ctx);
+}
+
+// Forgets everything learned from earlier searches (new game)
+void clear_search_context(SearchContext* ctx) {
+    clear_transposition_table(&ctx->tt);
+    memset(ctx->killer_moves, 0, sizeof(ctx->killer_moves));
+    memset(ctx->history_moves, 0, sizeof(ctx->history_moves));
+    memset(ctx->counter_moves, 0, sizeof(ctx->counter_moves));
+    memset(ctx->continuation_history, 0, sizeof(ctx->continuation_history));
+}
+
+// --- Shared Tables ---
+static pthread_once_t engine_once = PTHREAD_ONCE_INIT;
+
+static void init_shared_tables() {
+    init_attack_tables();
+    init_zobrist_keys();
+    init_evaluation_masks();
+    init_mobility();
+    init_search();
+}
+
+void init_engine() {
+    pthread_once(&engine_once, init_shared_tables);
+}
+
+// --- Default Context ---
+// The single-engine API below drives one context that is created on first
+// use, for callers (and tests) that never run more than one search.
+static SearchContext* default_context = NULL;
+
+static SearchContext* get_default_context() {
+    if (default_context == NULL) default_context = create_search_context(DEFAULT_HASH_MB);
+    return default_context;
+}
+
+Move search_with_limits(Board* board, const SearchLimits* limits) {
+    return search_with_context(get_default_context(), board, limits);
+}
+
+Move search_position(Board* board, int depth) {
+    SearchLimits limits = { .depth = depth };
+    return search_with_limits(board, &limits);
+}
+
+void stop_search() {
+    if (default_context) stop_search_context(default_context);
+}
+
+void ponderhit() {
+    if (default_context) ponderhit_context(default_context);
+}
+
+const SearchStats* get_search_stats() {
+    return get_context_stats(get_default_context());
+}
+
+int get_root_lines(RootLine* lines, int max_lines) {
+    return get_context_root_lines(get_default_context(), lines, max_lines);
+}
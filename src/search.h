@@ -3,15 +3,147 @@
 #ifndef SEARCH_H
 #define SEARCH_H
 
+#include <stdio.h>
 #include "board.h"
 
-// A very large number to represent infinity for alpha-beta search
-#define INFINITY 50000
+// A very large number to represent infinity for alpha-beta search (named so
+// it doesn't clash with math.h's float INFINITY)
+#define INFINITE_SCORE 50000
 // A value representing a checkmate score. The ply is subtracted
 // to prefer shorter mates.
-#define MATE_SCORE (INFINITY - 100)
+#define MATE_SCORE (INFINITE_SCORE - 100)
+// The deepest ply the search tables (killers, etc.) are sized for.
+#define MAX_PLY 128
+// The most lines a MultiPV search reports
+#define MAX_MULTIPV 64
+// Transposition table size of a context created by the single-engine API
+#define DEFAULT_HASH_MB 32
+
+// Limits for a single search. A field left at zero is not used; with no
+// limits set at all the search runs until MAX_PLY or stop_search().
+typedef struct {
+    int depth;      // Maximum iteration depth
+    int movetime;   // Fixed time for this move in milliseconds
+    int wtime;      // Remaining clock time for each side in milliseconds
+    int btime;
+    int winc;       // Increment per move for each side in milliseconds
+    int binc;
+    int movestogo;  // Moves until the next time control, 0 = sudden death
+    long nodes;     // Node budget
+    int infinite;   // Ignore the clock and search until stop_search()
+    int multipv;    // Number of ranked root moves to report, 0 or 1 = best move only
+    int ponder;     // Search without limits until ponderhit() or stop_search()
+    int mate;       // Stop once a mate in this many moves is proven
+} SearchLimits;
+
+// A root move and its score from the last completed iteration
+typedef struct {
+    Move move;
+    int score;
+} RootLine;
+
+// Tunable forward pruning parameters (see search.c for the defaults)
+typedef struct {
+    int rfp_depth;        // Reverse futility pruning: max depth, margin per ply
+    int rfp_margin;
+    int razor_depth;      // Razoring: max depth, margin per ply
+    int razor_margin;
+    int futility_depth;   // Futility pruning: max depth, base + margin per ply
+    int futility_base;
+    int futility_margin;
+    int lmp_depth;        // Late move pruning: max depth, quiets allowed = base + depth^2
+    int lmp_base;
+    int singular_depth;   // Singular extension: min depth, margin per ply below the TT score
+    int singular_margin;
+    int iir_depth;        // Internal iterative reductions: min depth for nodes without a TT move
+    int use_iid;          // Use internal iterative deepening (PV nodes only) instead of IIR
+    int null_min_depth;   // Null move: min depth, R = base + depth / divisor + (eval - beta) / eval divisor
+    int null_base_reduction;
+    int null_depth_divisor;
+    int null_eval_divisor;
+    int null_verify_depth; // Null move cutoffs from this depth on are verified by a normal search
+} SearchParams;
+
+extern SearchParams search_params;
+
+// Counters collected during the last search
+typedef struct {
+    int depth;                      // Last completed iteration
+    int seldepth;                   // Deepest ply reached, quiescence included
+    long nodes;                     // All nodes, and the quiescence share of them
+    long qnodes;
+    long long time_ms;
+    long tt_probes;                 // Probes, probes that found the position,
+    long tt_hits;                   // and probes whose score ended the node
+    long tt_cutoffs;
+    long null_tries;                // Null-move searches, and those that failed high
+    long null_cutoffs;
+    long beta_cutoffs;              // Beta cutoffs, and those on the first legal move
+    long first_move_cutoffs;
+    long lmr_searches;              // Reduced searches, and those re-searched at full depth
+    long lmr_researches;
+    long completed_nodes;           // Nodes up to the end of the last completed iteration
+    int aspiration_fail_lows;       // Root re-searches after failing low/high
+    int aspiration_fail_highs;
+    long aspiration_wasted_nodes;   // Nodes spent in searches that had to be repeated
+    long lazy_evals;                // Quiescence stand-pat evaluations, and those
+    long lazy_exits;                // decided by material + PST alone
+} SearchStats;
+
+// Owns everything one search writes: TT, move ordering heuristics, limits
+// and statistics. Independent contexts can search concurrently in separate
+// threads; each context runs one search at a time.
+typedef struct SearchContext SearchContext;
+
+// Initializes the shared read-only tables (attacks, Zobrist keys, evaluation
+// masks, reductions). Safe to call more than once and from several threads.
+void init_engine();
+
+// Precomputes the search tables (late move reductions). Called by init_engine().
+void init_search();
+
+// Returns NULL if the TT can't be allocated. Output goes to stdout until
+// changed with set_search_output() (NULL silences it).
+SearchContext* create_search_context(int hash_mb);
+void destroy_search_context(SearchContext* ctx);
+void clear_search_context(SearchContext* ctx);
+void set_search_output(SearchContext* ctx, FILE* output);
+
+Move search_with_context(SearchContext* ctx, Board* board, const SearchLimits* limits);
+// Safe to call from another thread while ctx is searching. A call made
+// before the search thread has started applies to that search: each search
+// consumes the signals when it returns.
+void stop_search_context(SearchContext* ctx);
+void ponderhit_context(SearchContext* ctx);
+
+// Statistics and ranked MultiPV results of ctx's last search
+const SearchStats* get_context_stats(const SearchContext* ctx);
+int get_context_root_lines(const SearchContext* ctx, RootLine* lines, int max_lines);
+// PV of the best line in SAN; 'board' must be the position that was searched
+int get_context_pv(SearchContext* ctx, Board* board, char* out, size_t size);
+
+// --- Single-engine API ---
+// The same operations on a default context created on first use.
 
 // The main entry point for finding the best move in a position.
 Move search_position(Board* board, int depth);
+Move search_with_limits(Board* board, const SearchLimits* limits);
+
+// Asks a running search to stop; it returns the last completed iteration's move.
+void stop_search();
+
+// Turns a running ponder search into a normal one: its time limits start
+// counting now. Safe to call from another thread.
+void ponderhit();
+
+// Statistics of the last (or running) search
+const SearchStats* get_search_stats();
+
+// Copies the ranked MultiPV results of the last search, best first.
+// Returns the number of lines copied.
+int get_root_lines(RootLine* lines, int max_lines);
+
+// Monotonic wall clock in milliseconds
+long long get_time_ms();
 
 #endif // SEARCH_H
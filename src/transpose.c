@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 #include "transpose.h"
 #include "defs.h"
 #include "movegen.h" // For rand64_prng()
@@ -10,10 +11,6 @@ u64 castle_keys[16];
 u64 side_key;
 u64 enpassant_keys[64];
 
-// --- Transposition Table ---
-#define HASH_SIZE 0x100000 // Size of the TT, must be a power of 2
-HashEntry* transposition_table = NULL;
-
 void init_zobrist_keys() {
     seed_prng(1070372); // Seed your PRNG
 
@@ -57,38 +54,111 @@ u64 generate_hash_key(const Board* board) {
     return final_key;
 }
 
-void init_transposition_table() {
-    if (transposition_table != NULL) {
-        free(transposition_table);
-    }
+// --- Transposition Table ---
+// Each search context owns its table. The entry count is the largest power
+// of 2 that fits in 'size_mb', so the index is a simple mask of the key.
+// Returns 0 if the memory could not be allocated.
+int init_transposition_table(TranspositionTable* tt, int size_mb) {
+    u64 entries = 1;
+    if (size_mb < 1) size_mb = 1;
+    while (entries * 2 * sizeof(HashEntry) <= (u64)size_mb << 20) entries *= 2;
+
     // Allocate memory for the transposition table and initialize it to zero
-    transposition_table = (HashEntry*)calloc(HASH_SIZE, sizeof(HashEntry));
+    tt->entries = (HashEntry*)calloc(entries, sizeof(HashEntry));
+    tt->mask = tt->entries ? entries - 1 : 0;
+    tt->generation = 0;
+    return tt->entries != NULL;
+}
+
+void free_transposition_table(TranspositionTable* tt) {
+    free(tt->entries);
+    tt->entries = NULL;
+    tt->mask = 0;
+}
+
+void clear_transposition_table(TranspositionTable* tt) {
+    memset(tt->entries, 0, (tt->mask + 1) * sizeof(HashEntry));
+    tt->generation = 0;
+}
+
+int probe_hash(const TranspositionTable* tt, u64 hash_key, int depth, int alpha, int beta, int* best_move) {
+    HashEntry entry;
+    *best_move = 0;
+
+    if (probe_hash_entry(tt, hash_key, &entry)) {
+        // The stored move is useful for ordering even when the depth is too shallow
+        *best_move = entry.best_move;
+        return hash_entry_score(&entry, depth, alpha, beta);
+    }
+    return NO_HASH_ENTRY;
 }
 
-int probe_hash(u64 hash_key, int depth, int alpha, int beta) {
-    HashEntry* entry = &transposition_table[hash_key & (HASH_SIZE - 1)];
-
-    if (entry->key == hash_key) {
-        if (entry->depth >= depth) {
-            if (entry->flags == HASH_FLAG_EXACT) {
-                return entry->score;
-            }
-            if ((entry->flags == HASH_FLAG_ALPHA) && (entry->score <= alpha)) {
-                return alpha;
-            }
-            if ((entry->flags == HASH_FLAG_BETA) && (entry->score >= beta)) {
-                return beta;
-            }
+// Starts loading the entry for this position into cache. Called right after
+// make_move() so the memory latency overlaps with the legality check that
+// runs before the child node probes the table.
+void prefetch_hash(const TranspositionTable* tt, u64 hash_key) {
+    __builtin_prefetch(&tt->entries[hash_key & tt->mask]);
+}
+
+// Copies the raw entry for this position, regardless of depth and bounds.
+// Returns 0 if the slot holds a different position.
+int probe_hash_entry(const TranspositionTable* tt, u64 hash_key, HashEntry* entry) {
+    *entry = tt->entries[hash_key & tt->mask];
+    return entry->key == hash_key;
+}
+
+// The score an already probed entry allows us to return for a search of
+// 'depth' with the window (alpha, beta), or NO_HASH_ENTRY if it can't cut.
+int hash_entry_score(const HashEntry* entry, int depth, int alpha, int beta) {
+    if (entry->depth >= depth) {
+        if (entry->flags == HASH_FLAG_EXACT) {
+            return entry->score;
+        }
+        if ((entry->flags == HASH_FLAG_ALPHA) && (entry->score <= alpha)) {
+            return alpha;
+        }
+        if ((entry->flags == HASH_FLAG_BETA) && (entry->score >= beta)) {
+            return beta;
         }
     }
     return NO_HASH_ENTRY;
 }
 
-void record_hash(u64 hash_key, int depth, int score, int hash_flag) {
-    HashEntry* entry = &transposition_table[hash_key & (HASH_SIZE - 1)];
+// Permille of a sample of the table written by the current search, as
+// reported in UCI's 'hashfull'
+int hash_full(const TranspositionTable* tt) {
+    int used = 0;
+    int sample = tt->mask + 1 < 1000 ? (int)tt->mask + 1 : 1000;
+    for (int i = 0; i < sample; i++) {
+        if (tt->entries[i].key != 0 && tt->entries[i].age == tt->generation) used++;
+    }
+    return used * 1000 / sample;
+}
+
+// Bumped once per search so entries from earlier searches can be replaced
+// even when they are deeper than the new data.
+void new_hash_generation(TranspositionTable* tt) {
+    tt->generation++;
+}
+
+void record_hash(TranspositionTable* tt, u64 hash_key, int depth, int score, int hash_flag, int best_move, int static_eval) {
+    HashEntry* entry = &tt->entries[hash_key & tt->mask];
 
+    // Depth-preferred replacement: don't let the many shallow (quiescence)
+    // stores of this search evict deeper results it may still need
+    if (entry->age == tt->generation) {
+        if (entry->key != hash_key && depth < entry->depth) return;
+        if (entry->key == hash_key && depth < entry->depth - 3 && hash_flag != HASH_FLAG_EXACT) return;
+    }
+
+    // Keep the previous move for this position if the new search found none
+    if (best_move != 0 || entry->key != hash_key) {
+        entry->best_move = best_move;
+    }
     entry->key = hash_key;
     entry->score = score;
     entry->flags = hash_flag;
     entry->depth = depth;
+    entry->static_eval = static_eval;
+    entry->age = tt->generation;
 }
\ No newline at end of file
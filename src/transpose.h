@@ -13,8 +13,17 @@ typedef struct {
     int depth;
     int flags;
     int score;
+    int best_move;   // Packed with pack_move(), 0 if no move is known
+    int static_eval; // Cached evaluate() result, NO_HASH_ENTRY if unknown
+    int age;         // Search generation that last wrote this entry
 } HashEntry;
 
+typedef struct {
+    HashEntry* entries;
+    u64 mask;        // Entry count - 1; the count is a power of 2
+    int generation;  // Current search generation, see new_hash_generation()
+} TranspositionTable;
+
 extern u64 piece_keys[12][64];
 extern u64 castle_keys[16];
 extern u64 side_key;
@@ -22,8 +31,15 @@ extern u64 enpassant_keys[64];
 
 void init_zobrist_keys();
 u64 generate_hash_key(const Board* board);
-void init_transposition_table();
-int probe_hash(u64 hash_key, int depth, int alpha, int beta);
-void record_hash(u64 hash_key, int depth, int score, int hash_flag);
+int init_transposition_table(TranspositionTable* tt, int size_mb);
+void free_transposition_table(TranspositionTable* tt);
+void clear_transposition_table(TranspositionTable* tt);
+int probe_hash(const TranspositionTable* tt, u64 hash_key, int depth, int alpha, int beta, int* best_move);
+int probe_hash_entry(const TranspositionTable* tt, u64 hash_key, HashEntry* entry);
+void prefetch_hash(const TranspositionTable* tt, u64 hash_key);
+int hash_entry_score(const HashEntry* entry, int depth, int alpha, int beta);
+void record_hash(TranspositionTable* tt, u64 hash_key, int depth, int score, int hash_flag, int best_move, int static_eval);
+void new_hash_generation(TranspositionTable* tt);
+int hash_full(const TranspositionTable* tt);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+// tests/mobility_bench.c
+// Checks that the mobility kernels agree and times them, alone and inside
+// evaluate(), on a fixed set of positions. Each position is timed with
+// repeated calls, as the search sees it: a Board is ~40 KB, so cycling
+// through all of them would measure cache misses instead.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "board.h"
+#include "search.h"
+#include "evaluate.h"
+#include "movegen.h"
+#include "mobility.h"
+
+#define RANDOM_POSITIONS 2000
+#define TIMING_ROUNDS 200
+
+static const char* fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+    "8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+    // Promoted pieces: more than two of a kind
+    "QQQQ4/8/8/8/3k4/8/8/4K1NN w - - 0 1",
+};
+
+#define FEN_COUNT ((int)(sizeof(fens) / sizeof(fens[0])))
+
+static Board positions[FEN_COUNT + RANDOM_POSITIONS];
+
+// Random legal walks from the openings above, for coverage
+static int build_positions() {
+    int count = 0;
+    for (int i = 0; i < FEN_COUNT; i++) parse_fen(&positions[count++], fens[i]);
+
+    srand(2024);
+    while (count < FEN_COUNT + RANDOM_POSITIONS) {
+        Board* board = &positions[count];
+        parse_fen(board, fens[rand() % 2]);
+        int plies = rand() % 60;
+        for (int ply = 0; ply < plies; ply++) {
+            MoveList move_list;
+            generate_all_moves(board, &move_list);
+            int side = board->side_to_move, made = 0;
+            for (int tries = 0; tries < move_list.count && !made; tries++) {
+                Move move = move_list.moves[rand() % move_list.count];
+                make_move(board, move);
+                u64 king_bb = board->piece_bitboards[side == WHITE ? K : k];
+                if (king_bb && !is_square_attacked(__builtin_ctzll(king_bb), !side, board)) made = 1;
+                else unmake_move(board, move);
+            }
+            if (!made) break;
+        }
+        // Keep the copy self-contained: make/unmake history is not needed
+        board->ply = 0;
+        count++;
+    }
+    return count;
+}
+
+static int same_mobility(const Mobility* a, const Mobility* b) {
+    for (int type = 0; type < 4; type++) {
+        if (a->count[type] != b->count[type]) return 0;
+        if (memcmp(a->moves[type], b->moves[type], a->count[type] * sizeof(int)) != 0) return 0;
+    }
+    return 1;
+}
+
+static void time_kernel(const char* name, void (*kernel)(const Board*, int, Mobility*), int count) {
+    Mobility mobility;
+    volatile int sink = 0;
+    long long start = get_time_ms();
+    for (int i = 0; i < count; i++) {
+        for (int round = 0; round < TIMING_ROUNDS; round++) {
+            kernel(&positions[i], WHITE, &mobility);
+            sink += mobility.count[0];
+            kernel(&positions[i], BLACK, &mobility);
+            sink += mobility.count[0];
+        }
+    }
+    long long elapsed = get_time_ms() - start;
+    printf("%-16s: %6.1f ns per side\n", name, elapsed * 1e6 / (2.0 * TIMING_ROUNDS * count));
+}
+
+static void time_evaluate(MobilityKernel kernel, int count) {
+    set_mobility_kernel(kernel);
+    volatile int sink = 0;
+    long long start = get_time_ms();
+    for (int i = 0; i < count; i++) {
+        for (int round = 0; round < TIMING_ROUNDS; round++) sink += evaluate(&positions[i]);
+    }
+    long long elapsed = get_time_ms() - start;
+    printf("evaluate (%s): %6.1f ns per call\n", mobility_kernel_name(), elapsed * 1e6 / ((double)TIMING_ROUNDS * count));
+}
+
+int main() {
+    init_engine();
+    int count = build_positions();
+
+    // --- Agreement ---
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        for (int side = WHITE; side <= BLACK; side++) {
+            Mobility magic, setwise, scalar;
+            mobility_magic(&positions[i], side, &magic);
+            mobility_setwise(&positions[i], side, &setwise);
+            mobility_setwise_scalar(&positions[i], side, &scalar);
+            if (!same_mobility(&magic, &setwise) || !same_mobility(&magic, &scalar)) mismatches++;
+        }
+    }
+    set_mobility_kernel(MOBILITY_SETWISE);
+    printf("Positions: %d, set-wise kernel: %s, mismatches: %d\n", count, mobility_kernel_name(), mismatches);
+
+    // --- Speed ---
+    time_kernel("magic", mobility_magic, count);
+    time_kernel("setwise", mobility_setwise, count);
+    time_kernel("setwise-scalar", mobility_setwise_scalar, count);
+    time_evaluate(MOBILITY_MAGIC, count);
+    time_evaluate(MOBILITY_SETWISE, count);
+    set_mobility_kernel(MOBILITY_MAGIC);
+    return mismatches != 0;
+}
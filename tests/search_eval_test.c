@@ -1,11 +1,16 @@
 // tests/search_eval_test.c
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
 #include "board.h"
 #include "search.h"
 #include "evaluate.h"
 #include "movegen.h"
 #include "transpose.h"
+#include "nnue.h"
 
 void run_test(const char* fen, int depth) {
     printf("\n--- Testing Position ---\n");
@@ -18,11 +23,319 @@ void run_test(const char* fen, int depth) {
     printf("------------------------\n");
 }
 
+void run_timed_test(const char* fen, int movetime) {
+    printf("\n--- Testing Position (movetime %d ms) ---\n", movetime);
+    printf("FEN: %s\n", fen);
+
+    Board board;
+    parse_fen(&board, fen);
+
+    SearchLimits limits = { .movetime = movetime };
+    long long start = get_time_ms();
+    search_with_limits(&board, &limits);
+    printf("Search took %lld ms\n", get_time_ms() - start);
+    printf("------------------------\n");
+}
+
+void run_mate_test(const char* fen, int mate_moves) {
+    printf("\n--- Testing Position (mate in %d) ---\n", mate_moves);
+    printf("FEN: %s\n", fen);
+
+    Board board;
+    parse_fen(&board, fen);
+
+    SearchLimits limits = { .mate = mate_moves };
+    long long start = get_time_ms();
+    search_with_limits(&board, &limits);
+    printf("Search took %lld ms\n", get_time_ms() - start);
+    printf("------------------------\n");
+}
+
+void run_multipv_test(const char* fen, int depth, int multipv) {
+    printf("\n--- Testing Position (MultiPV %d) ---\n", multipv);
+    printf("FEN: %s\n", fen);
+
+    Board board;
+    parse_fen(&board, fen);
+
+    SearchLimits limits = { .depth = depth, .multipv = multipv };
+    search_with_limits(&board, &limits);
+
+    RootLine lines[MAX_MULTIPV];
+    int count = get_root_lines(lines, MAX_MULTIPV);
+    for (int i = 0; i < count; i++) {
+        char san_move[16];
+        move_to_san(san_move, &board, lines[i].move);
+        printf("%d. %s (%d)\n", i + 1, san_move, lines[i].score);
+    }
+    printf("------------------------\n");
+}
+
+typedef struct {
+    Board board;
+    SearchLimits limits;
+} PonderJob;
+
+static void* ponder_thread(void* arg) {
+    PonderJob* job = arg;
+    search_with_limits(&job->board, &job->limits);
+    return NULL;
+}
+
+void run_ponder_test(const char* fen, int ponder_ms, int movetime) {
+    printf("\n--- Testing Ponder (ponderhit after %d ms, movetime %d ms) ---\n", ponder_ms, movetime);
+    printf("FEN: %s\n", fen);
+
+    PonderJob job = { .limits = { .movetime = movetime, .ponder = 1 } };
+    parse_fen(&job.board, fen);
+
+    long long start = get_time_ms();
+    pthread_t thread;
+    pthread_create(&thread, NULL, ponder_thread, &job);
+
+    struct timespec pause = { ponder_ms / 1000, (ponder_ms % 1000) * 1000000L };
+    nanosleep(&pause, NULL);
+    ponderhit();
+    long long hit = get_time_ms();
+
+    pthread_join(thread, NULL);
+    printf("Search took %lld ms after the ponderhit (%lld ms in total)\n", get_time_ms() - hit, get_time_ms() - start);
+    printf("------------------------\n");
+}
+
+typedef struct {
+    SearchContext* ctx;
+    Board board;
+    int depth;
+    Move best_move;
+} ContextJob;
+
+static void* context_thread(void* arg) {
+    ContextJob* job = arg;
+    SearchLimits limits = { .depth = job->depth };
+    job->best_move = search_with_context(job->ctx, &job->board, &limits);
+    return NULL;
+}
+
+// Runs independent searches of the same positions at once, each in its own
+// context, and reports their node counts next to those of a search of the
+// position on its own: with nothing shared and the same hash size they
+// must match.
+void run_concurrent_test(const char* fens[], int count, int depth) {
+    printf("\n--- Testing Concurrent Search Contexts ---\n");
+
+    ContextJob solo[2];
+    for (int i = 0; i < 2; i++) {
+        solo[i].ctx = create_search_context(DEFAULT_HASH_MB);
+        solo[i].depth = depth;
+        set_search_output(solo[i].ctx, NULL);
+        parse_fen(&solo[i].board, fens[i]);
+        context_thread(&solo[i]);
+    }
+
+    ContextJob jobs[8];
+    pthread_t threads[8];
+    for (int i = 0; i < count; i++) {
+        jobs[i].ctx = create_search_context(DEFAULT_HASH_MB);
+        jobs[i].depth = depth;
+        set_search_output(jobs[i].ctx, NULL);
+        parse_fen(&jobs[i].board, fens[i % 2]);
+        pthread_create(&threads[i], NULL, context_thread, &jobs[i]);
+    }
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        pthread_join(threads[i], NULL);
+        Move move = jobs[i].best_move, solo_move = solo[i % 2].best_move;
+        long nodes = get_context_stats(jobs[i].ctx)->nodes;
+        long solo_nodes = get_context_stats(solo[i % 2].ctx)->nodes;
+        if (nodes != solo_nodes || move.from != solo_move.from || move.to != solo_move.to) mismatches++;
+        char san_move[16];
+        move_to_san(san_move, &jobs[i].board, move);
+        printf("Context %d: %s, %ld nodes (alone: %ld)\n", i, san_move, nodes, solo_nodes);
+        destroy_search_context(jobs[i].ctx);
+    }
+    for (int i = 0; i < 2; i++) destroy_search_context(solo[i].ctx);
+    printf("Mismatches with a search on its own: %d\n", mismatches);
+    printf("------------------------\n");
+}
+
+void run_see_test(const char* fen, int from, int to, int expected) {
+    Board board;
+    parse_fen(&board, fen);
+
+    MoveList move_list;
+    generate_all_moves(&board, &move_list);
+    for (int i = 0; i < move_list.count; i++) {
+        Move move = move_list.moves[i];
+        if (move.from == from && move.to == to) {
+            char san_move[16];
+            move_to_san(san_move, &board, move);
+            printf("SEE %s: %d (expected %d)\n", san_move, see(&board, move), expected);
+            return;
+        }
+    }
+    printf("SEE: move not found in %s\n", fen);
+}
+
+void run_draw_test(const char* fen, const char* moves, int depth) {
+    printf("\n--- Testing Draw Detection ---\n");
+    printf("FEN: %s\nMoves: %s\n", fen, moves);
+
+    Board board;
+    parse_fen(&board, fen);
+    int played = parse_game_moves(&board, moves);
+    printf("Played %d moves, repetition: %d, fifty-move: %d\n",
+           played, is_repetition(&board, board.ply), is_fifty_move_draw(&board));
+
+    search_position(&board, depth);
+    printf("------------------------\n");
+}
+
+// Writes a network of small pseudo-random weights in the nnue.h format.
+// It plays nonsense, but exercises every feature column.
+int write_test_network(FILE* file) {
+    if (file == NULL) return 0;
+
+    unsigned int seed = 12345;
+    u32 hidden = NNUE_HIDDEN;
+    fwrite("SCYNNUE1", 1, 8, file);
+    fwrite(&hidden, sizeof(hidden), 1, file);
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        i16 bias = rand_r(&seed) % 64;
+        fwrite(&bias, sizeof(bias), 1, file);
+    }
+    i16* column = malloc(NNUE_HIDDEN * sizeof(i16));
+    for (int feature = 0; feature < NNUE_INPUTS; feature++) {
+        for (int i = 0; i < NNUE_HIDDEN; i++) column[i] = rand_r(&seed) % 17 - 8;
+        fwrite(column, sizeof(i16), NNUE_HIDDEN, file);
+    }
+    free(column);
+    i32 output_bias = 0;
+    fwrite(&output_bias, sizeof(output_bias), 1, file);
+    for (int i = 0; i < 2 * NNUE_HIDDEN; i++) {
+        int8_t weight = rand_r(&seed) % 65 - 32;
+        fwrite(&weight, sizeof(weight), 1, file);
+    }
+    return fclose(file) == 0;
+}
+
+// Compares the incrementally updated evaluation of every position in the
+// tree with one computed from scratch
+long count_nnue_mismatches(Board* board, NnueStack* fresh, int depth, long* positions) {
+    // Switch the board to a refreshed stack for one evaluation and back,
+    // rather than copy the whole board
+    NnueStack* incremental = board->nnue;
+    int incremental_score = nnue_evaluate(board);
+    nnue_attach(board, fresh);
+    long mismatches = incremental_score != nnue_evaluate(board);
+    board->nnue = incremental;
+    (*positions)++;
+    if (depth == 0) return mismatches;
+
+    MoveList move_list;
+    generate_all_moves(board, &move_list);
+    int side = board->side_to_move;
+    for (int i = 0; i < move_list.count; i++) {
+        make_move(board, move_list.moves[i]);
+        u64 king_bb = board->piece_bitboards[side == WHITE ? K : k];
+        if (king_bb && !is_square_attacked(__builtin_ctzll(king_bb), !side, board)) {
+            mismatches += count_nnue_mismatches(board, fresh, depth - 1, positions);
+        }
+        unmake_move(board, move_list.moves[i]);
+    }
+    return mismatches;
+}
+
+void run_nnue_test(const char* fen, int depth) {
+    printf("\n--- Testing NNUE Accumulators (%s kernels) ---\n", nnue_kernel());
+    printf("FEN: %s\n", fen);
+
+    Board board;
+    parse_fen(&board, fen);
+    NnueStack* incremental = nnue_create_stack();
+    NnueStack* fresh = nnue_create_stack();
+    nnue_attach(&board, incremental);
+
+    long positions = 0;
+    long mismatches = count_nnue_mismatches(&board, fresh, depth, &positions);
+    printf("Positions: %ld, mismatches: %ld\n", positions, mismatches);
+
+    nnue_attach(&board, NULL);
+    nnue_destroy_stack(incremental);
+    nnue_destroy_stack(fresh);
+    printf("------------------------\n");
+}
+
+// Makes the same moves on two boards, one updated with the SIMD kernels and
+// one with the scalar ones, and compares their accumulators and scores
+long count_kernel_mismatches(Board* simd, Board* scalar, int depth, long* positions) {
+    nnue_force_scalar(0);
+    int simd_score = nnue_evaluate(simd);
+    nnue_force_scalar(1);
+    int scalar_score = nnue_evaluate(scalar);
+    long mismatches = simd_score != scalar_score
+        || memcmp(&simd->nnue->accumulators[simd->ply], &scalar->nnue->accumulators[scalar->ply], sizeof(NnueAccumulator)) != 0;
+    (*positions)++;
+    if (depth == 0) return mismatches;
+
+    MoveList move_list;
+    generate_all_moves(simd, &move_list);
+    int side = simd->side_to_move;
+    for (int i = 0; i < move_list.count; i++) {
+        nnue_force_scalar(0);
+        make_move(simd, move_list.moves[i]);
+        nnue_force_scalar(1);
+        make_move(scalar, move_list.moves[i]);
+        u64 king_bb = simd->piece_bitboards[side == WHITE ? K : k];
+        if (king_bb && !is_square_attacked(__builtin_ctzll(king_bb), !side, simd)) {
+            mismatches += count_kernel_mismatches(simd, scalar, depth - 1, positions);
+        }
+        unmake_move(simd, move_list.moves[i]);
+        unmake_move(scalar, move_list.moves[i]);
+    }
+    return mismatches;
+}
+
+void run_nnue_kernel_test(const char* fen, int depth) {
+    printf("\n--- Testing NNUE Kernels (%s against scalar) ---\n", nnue_kernel());
+    printf("FEN: %s\n", fen);
+    if (strcmp(nnue_kernel(), "scalar") == 0) {
+        printf("Skipped: this CPU only has the scalar kernels\n");
+        printf("------------------------\n");
+        return;
+    }
+
+    Board simd, scalar;
+    parse_fen(&simd, fen);
+    parse_fen(&scalar, fen);
+    NnueStack* simd_stack = nnue_create_stack();
+    NnueStack* scalar_stack = nnue_create_stack();
+    nnue_force_scalar(0);
+    nnue_attach(&simd, simd_stack);
+    nnue_force_scalar(1);
+    nnue_attach(&scalar, scalar_stack);
+
+    long positions = 0;
+    long mismatches = count_kernel_mismatches(&simd, &scalar, depth, &positions);
+    nnue_force_scalar(0);
+    printf("Positions: %ld, kernel mismatches: %ld\n", positions, mismatches);
+
+    nnue_attach(&simd, NULL);
+    nnue_attach(&scalar, NULL);
+    nnue_destroy_stack(simd_stack);
+    nnue_destroy_stack(scalar_stack);
+    printf("------------------------\n");
+}
+
 int main() {
-    init_evaluation_masks();
-    init_zobrist_keys();
-    init_attack_tables();
-    init_transposition_table();
+    init_engine();
+
+    // --- Static Exchange Evaluation ---
+    printf("\n--- Testing Static Exchange Evaluation ---\n");
+    // Rook takes an undefended pawn
+    run_see_test("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", e1, e5, 100);
+    // Knight takes a pawn defended by the bishop, with x-rays behind both sides
+    run_see_test("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", d3, e5, -200);
 
     // --- Test 1: Starting Position ---
     const char* start_pos_fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
@@ -35,15 +348,73 @@ int main() {
     run_test(kiwipete_fen, 4);
 
     // --- Test 3: Simple Mate-in-1 ---
-    // The engine should find Qxf2#.
-    // NOTE: Only finds Qxf2# on a depth of 2 for some reason
-    const char* mate_in_1_fen = "r1b1k1nr/pppp1ppp/5q2/N1b5/4P3/8/PPP2PPP/RNBQKB1R w KQkq - 2 6";
-    run_test(mate_in_1_fen, 2);
+    // Black to move should find Qxf2#. The check extension lets the
+    // search see the mate at depth 1.
+    const char* mate_in_1_fen = "r1b1k1nr/pppp1ppp/5q2/N1b5/4P3/8/PPP2PPP/RNBQKB1R b KQkq - 2 6";
+    run_test(mate_in_1_fen, 1);
+
+    // --- Test 3b: Defending against the Mate-in-1 ---
+    // With White to move, the engine must stop Qxf2# (e.g. Qf3, Qe2 or Qd2).
+    run_test("r1b1k1nr/pppp1ppp/5q2/N1b5/4P3/8/PPP2PPP/RNBQKB1R w KQkq - 2 6", 2);
 
 
     // --- Test 4: Simple Endgame ---
     const char* endgame_fen = "8/k7/p7/P1p5/2P5/8/1K6/8 w - - 0 1";
     run_test(endgame_fen, 13);
 
+    // --- Test 5: Draw Detection ---
+    // After the knights shuffle back twice the start position is on the board
+    // for the third time (expected repetition: 1).
+    run_draw_test(start_pos_fen, "g1f3 g8f6 f3g1 f6g8 g1f3 g8f6 f3g1 f6g8", 4);
+    // White is a rook up but the halfmove clock is at 99: only a capture or
+    // pawn move avoids the draw, and none is available, so the score is 0.
+    run_draw_test("8/8/8/3k4/8/8/8/R3K3 w - - 99 80", "", 4);
+    // Here Ra8# is the hundredth half-move: mate takes precedence over the
+    // fifty-move draw (expected score: mate 1).
+    run_draw_test("6k1/5ppp/8/8/8/8/8/R5K1 w - - 99 80", "", 4);
+
+    // --- Test 6: Timed Search ---
+    // Should use the whole allotted time and still report a legal move.
+    run_timed_test(kiwipete_fen, 500);
+
+    // --- Test 7: MultiPV ---
+    // Three ranked lines, best first; the first should match a normal search.
+    run_multipv_test(kiwipete_fen, 6, 3);
+
+    // --- Test 8: Pondering ---
+    // The search keeps going through the ponder phase and then stops about
+    // 'movetime' after the ponderhit, not after the start.
+    run_ponder_test(kiwipete_fen, 300, 300);
+
+    // --- Test 9: Mate Search ---
+    // Nf6+ gxf6 Bxf7#: should report "score mate 2" and stop right there.
+    run_mate_test("r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1", 2);
+
+    // --- Test 10: Concurrent Search Contexts ---
+    // Contexts 0/2 and 1/3 search the same position and should agree exactly
+    // with a search of it on its own (expected mismatches: 0).
+    const char* concurrent_fens[] = { start_pos_fen, kiwipete_fen };
+    run_concurrent_test(concurrent_fens, 4, 7);
+
+    // --- Test 11: NNUE ---
+    // Incremental accumulators must match a refresh after every move
+    // (expected mismatches: 0), including castling, en passant, promotions
+    // and king moves. The SIMD kernels must give exactly the scalar results
+    // (expected kernel mismatches: 0). The search then runs on the network's
+    // evaluation.
+    char network_path[] = "/tmp/scylla_test_XXXXXX";
+    int network_fd = mkstemp(network_path);
+    if (network_fd >= 0 && write_test_network(fdopen(network_fd, "wb")) && nnue_load(network_path)) {
+        run_nnue_test(kiwipete_fen, 3);
+        run_nnue_test("n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1", 3);
+        run_nnue_kernel_test(kiwipete_fen, 3);
+        run_nnue_kernel_test("n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1", 3);
+        run_test("n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1", 6);
+        nnue_set_enabled(0);
+    } else {
+        printf("\nNNUE test skipped: can't write a network to %s\n", network_path);
+    }
+    if (network_fd >= 0) remove(network_path);
+
     return 0;
 }
\ No newline at end of file
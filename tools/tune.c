@@ -0,0 +1,510 @@
+// tools/tune.c
+// Texel tuning of the evaluation weights in src/evaluate.c.
+//
+// The classical evaluation is linear in its weights once the game phase is
+// known: every term is (white count - black count) * weight, blended by
+// phase. Each labeled position is therefore reduced to a short list of
+// (weight index, coefficient) terms, and an epoch is a pass over those
+// arrays rather than over boards. The mean squared error between the game
+// result and sigmoid(K * eval) is minimized with Adam, using full-batch
+// gradients summed over all threads.
+//
+// Input: one position per line, a FEN followed by the result, either as
+// [1.0] / [0.5] / [0.0] or as "1-0" / "1/2-1/2" / "0-1". Positions in check
+// or with a winning capture (SEE > 0) are skipped, since the static eval
+// can't be expected to match their outcome.
+//
+// usage: tune <dataset> [epochs] [threads] [output.c]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "scylla.h"
+
+#define TUNE_MAX_THREADS 64
+#define TUNE_MAX_TERMS 256
+#define TUNE_CHECKED_POSITIONS 1000  // Per thread, against evaluate()
+
+// --- Weight Layout ---
+enum {
+    W_MATERIAL = 0,                    // P..Q, kings have no material value
+    W_PST = W_MATERIAL + 5,            // [piece type][square], White's view
+    W_KNIGHT_MOBILITY = W_PST + 6 * 64,
+    W_BISHOP_MOBILITY = W_KNIGHT_MOBILITY + 9,
+    W_ROOK_MOBILITY = W_BISHOP_MOBILITY + 14,
+    W_QUEEN_MOBILITY = W_ROOK_MOBILITY + 15,
+    W_PASSED_PAWN = W_QUEEN_MOBILITY + 28,
+    W_DOUBLED_PAWN,
+    W_ISOLATED_PAWN,
+    WEIGHT_COUNT
+};
+
+typedef struct {
+    i16 index;
+    i16 coefficient;  // White's count minus Black's
+} Term;
+
+typedef struct {
+    float result;     // 1 = White won, 0.5 = draw, 0 = Black won
+    u32 first_term;
+    u16 term_count;   // Up to TUNE_MAX_TERMS
+    u8 phase;         // 0 (bare kings and pawns) .. 24
+} TunePosition;
+
+// Each thread loads and later scores its own slice of the dataset
+typedef struct {
+    char** lines;
+    long line_count;
+
+    TunePosition* positions;
+    long position_count;
+    Term* terms;
+    long term_count;
+    long skipped;
+    double model_error;  // Largest difference to evaluate() among the checked positions
+
+    // Inputs and outputs of the current pass
+    const double (*weights)[2];
+    double k;
+    double loss;
+    double gradient[WEIGHT_COUNT][2];
+} Shard;
+
+static double weights[WEIGHT_COUNT][2];
+
+// --- Feature Extraction ---
+// Must mirror evaluate() term for term; main() checks that it does.
+
+static void add_mobility(int* coefficients, int base, u64 bitboard, u64 own, u64 occupancy, int piece_type, int sign) {
+    while (bitboard) {
+        int square = __builtin_ctzll(bitboard);
+        u64 attacks = piece_type == N ? knight_attacks[square]
+                    : piece_type == B ? bishopAttacks(occupancy, square)
+                    : piece_type == R ? rookAttacks(occupancy, square)
+                    : bishopAttacks(occupancy, square) | rookAttacks(occupancy, square);
+        coefficients[base + popcount(attacks & ~own)] += sign;
+        bitboard &= bitboard - 1;
+    }
+}
+
+static void add_pawn_structure(int* coefficients, u64 pawns, u64 enemy_pawns, int side, int sign) {
+    u64 bitboard = pawns;
+    while (bitboard) {
+        int square = __builtin_ctzll(bitboard);
+        int file = square % 8;
+        if ((passed_pawn_masks[side][square] & enemy_pawns) == 0) coefficients[W_PASSED_PAWN] += sign;
+        if (popcount(pawns & file_masks[file]) > 1) coefficients[W_DOUBLED_PAWN] += sign;
+        if ((adjacent_file_masks[file] & pawns) == 0) coefficients[W_ISOLATED_PAWN] += sign;
+        bitboard &= bitboard - 1;
+    }
+}
+
+static int extract_terms(const Board* board, Term* terms) {
+    int coefficients[WEIGHT_COUNT] = {0};
+
+    for (int piece = P; piece <= k; piece++) {
+        int type = piece % 6;
+        int sign = piece < 6 ? 1 : -1;
+        u64 bitboard = board->piece_bitboards[piece];
+        while (bitboard) {
+            int square = __builtin_ctzll(bitboard);
+            if (type != K) coefficients[W_MATERIAL + type] += sign;
+            coefficients[W_PST + type * 64 + (piece < 6 ? square : square ^ 56)] += sign;
+            bitboard &= bitboard - 1;
+        }
+    }
+
+    u64 occupancy = board->occupancies[BOTH];
+    for (int side = WHITE; side <= BLACK; side++) {
+        int sign = side == WHITE ? 1 : -1;
+        int offset = side == WHITE ? 0 : 6;
+        u64 own = board->occupancies[side];
+        add_mobility(coefficients, W_KNIGHT_MOBILITY, board->piece_bitboards[N + offset], own, occupancy, N, sign);
+        add_mobility(coefficients, W_BISHOP_MOBILITY, board->piece_bitboards[B + offset], own, occupancy, B, sign);
+        add_mobility(coefficients, W_ROOK_MOBILITY, board->piece_bitboards[R + offset], own, occupancy, R, sign);
+        add_mobility(coefficients, W_QUEEN_MOBILITY, board->piece_bitboards[Q + offset], own, occupancy, Q, sign);
+    }
+    add_pawn_structure(coefficients, board->piece_bitboards[P], board->piece_bitboards[p], WHITE, 1);
+    add_pawn_structure(coefficients, board->piece_bitboards[p], board->piece_bitboards[P], BLACK, -1);
+
+    int count = 0;
+    for (int i = 0; i < WEIGHT_COUNT && count < TUNE_MAX_TERMS; i++) {
+        if (coefficients[i]) terms[count++] = (Term){ (i16)i, (i16)coefficients[i] };
+    }
+    return count;
+}
+
+static int phase_of(const Board* board) {
+    return board->game_phase > 24 ? 24 : board->game_phase;
+}
+
+// White-relative evaluation of a position from its terms
+static double linear_eval(const TunePosition* position, const Term* terms, const double (*w)[2]) {
+    double mg = 0, eg = 0;
+    for (int i = 0; i < position->term_count; i++) {
+        mg += terms[i].coefficient * w[terms[i].index][0];
+        eg += terms[i].coefficient * w[terms[i].index][1];
+    }
+    return (mg * position->phase + eg * (24 - position->phase)) / 24;
+}
+
+// --- Loading ---
+
+static int parse_result(const char* line, float* result) {
+    const char* bracket = strchr(line, '[');
+    if (bracket) {
+        *result = (float)atof(bracket + 1);
+        return 1;
+    }
+    if (strstr(line, "1/2-1/2")) { *result = 0.5f; return 1; }
+    if (strstr(line, "1-0")) { *result = 1.0f; return 1; }
+    if (strstr(line, "0-1")) { *result = 0.0f; return 1; }
+    return 0;
+}
+
+static int is_quiet(Board* board) {
+    int side = board->side_to_move;
+    u64 king_bb = board->piece_bitboards[side == WHITE ? K : k];
+    if (king_bb == 0 || is_square_attacked(__builtin_ctzll(king_bb), !side, board)) return 0;
+
+    MoveList move_list;
+    generate_all_moves(board, &move_list);
+    for (int i = 0; i < move_list.count; i++) {
+        if (move_list.moves[i].is_capture && see(board, move_list.moves[i]) > 0) return 0;
+    }
+    return 1;
+}
+
+static void* load_shard(void* arg) {
+    Shard* shard = arg;
+    shard->positions = malloc(shard->line_count * sizeof(TunePosition));
+    long term_capacity = shard->line_count * 48 + TUNE_MAX_TERMS;
+    shard->terms = malloc(term_capacity * sizeof(Term));
+    if (shard->positions == NULL || shard->terms == NULL) return NULL;
+
+    Board board;
+    Term terms[TUNE_MAX_TERMS];
+    for (long i = 0; i < shard->line_count; i++) {
+        const char* line = shard->lines[i];
+        float result;
+        if (!parse_result(line, &result) || !strchr(line, '/')) {
+            shard->skipped++;
+            continue;
+        }
+        parse_fen(&board, line);
+        if (!is_quiet(&board)) {
+            shard->skipped++;
+            continue;
+        }
+
+        int count = extract_terms(&board, terms);
+        if (shard->term_count + count > term_capacity) {
+            term_capacity *= 2;
+            Term* grown = realloc(shard->terms, term_capacity * sizeof(Term));
+            if (grown == NULL) break;
+            shard->terms = grown;
+        }
+        memcpy(shard->terms + shard->term_count, terms, count * sizeof(Term));
+        TunePosition* position = &shard->positions[shard->position_count++];
+        *position = (TunePosition){
+            .result = result, .first_term = (u32)shard->term_count, .term_count = (u16)count, .phase = (u8)phase_of(&board),
+        };
+        shard->term_count += count;
+
+        // The model must agree with evaluate(), up to its integer rounding
+        if (shard->position_count <= TUNE_CHECKED_POSITIONS) {
+            int eval = evaluate(&board);
+            if (board.side_to_move == BLACK) eval = -eval;
+            double difference = fabs(linear_eval(position, terms, (const double (*)[2])weights) - eval);
+            if (difference > shard->model_error) shard->model_error = difference;
+        }
+    }
+    return NULL;
+}
+
+// Reads the whole file and splits it into lines in place
+static char** read_lines(const char* path, long* line_count, char** buffer) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    *buffer = malloc(size + 1);
+    if (*buffer == NULL || fread(*buffer, 1, size, file) != (size_t)size) {
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    (*buffer)[size] = '\0';
+
+    long capacity = size / 40 + 16, count = 0;
+    char** lines = malloc(capacity * sizeof(char*));
+    for (char* line = strtok(*buffer, "\r\n"); line && lines; line = strtok(NULL, "\r\n")) {
+        if (count == capacity) {
+            capacity *= 2;
+            lines = realloc(lines, capacity * sizeof(char*));
+            if (lines == NULL) break;
+        }
+        lines[count++] = line;
+    }
+    *line_count = count;
+    return lines;
+}
+
+// --- Loss and Gradient ---
+
+static double sigmoid(double k, double eval) {
+    return 1.0 / (1.0 + pow(10.0, -k * eval / 400.0));
+}
+
+static void* loss_shard(void* arg) {
+    Shard* shard = arg;
+    shard->loss = 0;
+    for (long i = 0; i < shard->position_count; i++) {
+        const TunePosition* position = &shard->positions[i];
+        double error = position->result - sigmoid(shard->k, linear_eval(position, shard->terms + position->first_term, shard->weights));
+        shard->loss += error * error;
+    }
+    return NULL;
+}
+
+static void* gradient_shard(void* arg) {
+    Shard* shard = arg;
+    memset(shard->gradient, 0, sizeof(shard->gradient));
+    shard->loss = 0;
+
+    for (long i = 0; i < shard->position_count; i++) {
+        const TunePosition* position = &shard->positions[i];
+        const Term* terms = shard->terms + position->first_term;
+        double s = sigmoid(shard->k, linear_eval(position, terms, shard->weights));
+        double error = position->result - s;
+        shard->loss += error * error;
+
+        // d(error^2)/d(eval), then split between the mg and eg weights
+        double slope = -2.0 * error * s * (1.0 - s) * shard->k * log(10.0) / 400.0;
+        double mg_share = slope * position->phase / 24.0;
+        double eg_share = slope * (24 - position->phase) / 24.0;
+        for (int t = 0; t < position->term_count; t++) {
+            shard->gradient[terms[t].index][0] += mg_share * terms[t].coefficient;
+            shard->gradient[terms[t].index][1] += eg_share * terms[t].coefficient;
+        }
+    }
+    return NULL;
+}
+
+static void run_shards(Shard* shards, int threads, void* (*job)(void*)) {
+    pthread_t workers[TUNE_MAX_THREADS];
+    int started[TUNE_MAX_THREADS];
+    for (int i = 0; i < threads; i++) {
+        started[i] = pthread_create(&workers[i], NULL, job, &shards[i]) == 0;
+        // No thread for this shard: do its share here rather than lose it
+        if (!started[i]) job(&shards[i]);
+    }
+    for (int i = 0; i < threads; i++) {
+        if (started[i]) pthread_join(workers[i], NULL);
+    }
+}
+
+static double total_loss(Shard* shards, int threads, long positions, double k) {
+    for (int i = 0; i < threads; i++) {
+        shards[i].k = k;
+        shards[i].weights = (const double (*)[2])weights;
+    }
+    run_shards(shards, threads, loss_shard);
+    double loss = 0;
+    for (int i = 0; i < threads; i++) loss += shards[i].loss;
+    return loss / positions;
+}
+
+// The sigmoid scale that best fits the current weights, by narrowing scans
+static double fit_k(Shard* shards, int threads, long positions) {
+    double best_k = 1.0, best_loss = total_loss(shards, threads, positions, best_k);
+    for (double step = 0.5; step > 0.001; step /= 4) {
+        double center = best_k;
+        for (int i = -4; i <= 4; i++) {
+            double k = center + i * step;
+            if (k <= 0) continue;
+            double loss = total_loss(shards, threads, positions, k);
+            if (loss < best_loss) {
+                best_loss = loss;
+                best_k = k;
+            }
+        }
+    }
+    return best_k;
+}
+
+// --- Output ---
+
+static void load_current_weights() {
+    for (int type = P; type <= Q; type++) {
+        weights[W_MATERIAL + type][0] = material_score[type].mg;
+        weights[W_MATERIAL + type][1] = material_score[type].eg;
+    }
+    for (int type = P; type <= K; type++) {
+        for (int sq = 0; sq < 64; sq++) {
+            weights[W_PST + type * 64 + sq][0] = psts[type][sq].mg;
+            weights[W_PST + type * 64 + sq][1] = psts[type][sq].eg;
+        }
+    }
+    struct { int base; const Score* table; int size; } mobility[] = {
+        { W_KNIGHT_MOBILITY, knight_mobility, 9 }, { W_BISHOP_MOBILITY, bishop_mobility, 14 },
+        { W_ROOK_MOBILITY, rook_mobility, 15 }, { W_QUEEN_MOBILITY, queen_mobility, 28 },
+    };
+    for (int m = 0; m < 4; m++) {
+        for (int i = 0; i < mobility[m].size; i++) {
+            weights[mobility[m].base + i][0] = mobility[m].table[i].mg;
+            weights[mobility[m].base + i][1] = mobility[m].table[i].eg;
+        }
+    }
+    const Score* pawn_terms[3] = { &passed_pawn_bonus, &doubled_pawn_penalty, &isolated_pawn_penalty };
+    for (int i = 0; i < 3; i++) {
+        weights[W_PASSED_PAWN + i][0] = pawn_terms[i]->mg;
+        weights[W_PASSED_PAWN + i][1] = pawn_terms[i]->eg;
+    }
+}
+
+static void print_score(FILE* out, int index) {
+    fprintf(out, "{%d,%d}", (int)lround(weights[index][0]), (int)lround(weights[index][1]));
+}
+
+static void print_table(FILE* out, const char* declaration, int base, int size, int per_line) {
+    fprintf(out, "%s = {\n    ", declaration);
+    for (int i = 0; i < size; i++) {
+        print_score(out, base + i);
+        if (i + 1 < size) fprintf(out, (i + 1) % per_line ? "," : ",\n    ");
+    }
+    fprintf(out, "\n};\n\n");
+}
+
+static void print_weights(FILE* out) {
+    static const char* pst_names[6] = { "pawn_pst", "knight_pst", "bishop_pst", "rook_pst", "queen_pst", "king_pst" };
+
+    fprintf(out, "// Generated by tools/tune.c\n\n");
+    fprintf(out, "const Score material_score[12] = {\n    ");
+    for (int side = 0; side < 2; side++) {
+        for (int type = P; type <= Q; type++) {
+            fprintf(out, "{ %d, %d }, ", (int)lround(weights[W_MATERIAL + type][0]), (int)lround(weights[W_MATERIAL + type][1]));
+        }
+        fprintf(out, side == 0 ? "{ 0, 0 },\n    " : "{ 0, 0 }\n};\n\n");
+    }
+    print_table(out, "const Score knight_mobility[9]", W_KNIGHT_MOBILITY, 9, 9);
+    print_table(out, "const Score bishop_mobility[14]", W_BISHOP_MOBILITY, 14, 14);
+    print_table(out, "const Score rook_mobility[15]", W_ROOK_MOBILITY, 15, 15);
+    print_table(out, "const Score queen_mobility[28]", W_QUEEN_MOBILITY, 28, 14);
+    for (int type = P; type <= K; type++) {
+        char declaration[64];
+        snprintf(declaration, sizeof(declaration), "const Score %s[64]", pst_names[type]);
+        print_table(out, declaration, W_PST + type * 64, 64, 8);
+    }
+    const char* pawn_names[3] = { "passed_pawn_bonus", "doubled_pawn_penalty", "isolated_pawn_penalty" };
+    for (int i = 0; i < 3; i++) {
+        fprintf(out, "const Score %s = { %d, %d };\n", pawn_names[i],
+                (int)lround(weights[W_PASSED_PAWN + i][0]), (int)lround(weights[W_PASSED_PAWN + i][1]));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("usage: tune <dataset> [epochs] [threads] [output.c]\n");
+        return 1;
+    }
+    int epochs = argc > 2 ? atoi(argv[2]) : 100;
+    int threads = argc > 3 ? atoi(argv[3]) : 1;
+    const char* output_path = argc > 4 ? argv[4] : NULL;
+    if (threads < 1) threads = 1;
+    if (threads > TUNE_MAX_THREADS) threads = TUNE_MAX_THREADS;
+
+    init_engine();
+    load_current_weights();
+
+    long long start = get_time_ms();
+    long line_count = 0;
+    char* buffer = NULL;
+    char** lines = read_lines(argv[1], &line_count, &buffer);
+    if (lines == NULL) {
+        fprintf(stderr, "tune: can't read %s\n", argv[1]);
+        return 1;
+    }
+
+    Shard* shards = calloc(threads, sizeof(Shard));
+    for (int i = 0; i < threads; i++) {
+        long first = line_count * i / threads;
+        shards[i].lines = lines + first;
+        shards[i].line_count = line_count * (i + 1) / threads - first;
+    }
+    run_shards(shards, threads, load_shard);
+    free(lines);
+    free(buffer);
+
+    long positions = 0, skipped = 0, terms = 0;
+    for (int i = 0; i < threads; i++) {
+        positions += shards[i].position_count;
+        skipped += shards[i].skipped;
+        terms += shards[i].term_count;
+    }
+    printf("Loaded %ld positions (%ld skipped), %.1f terms each, %.1f MB, in %lld ms\n",
+           positions, skipped, positions ? (double)terms / positions : 0.0,
+           (positions * sizeof(TunePosition) + terms * sizeof(Term)) / 1048576.0, get_time_ms() - start);
+    if (positions == 0) return 1;
+
+    double model_error = 0;
+    for (int i = 0; i < threads; i++) {
+        if (shards[i].model_error > model_error) model_error = shards[i].model_error;
+    }
+    printf("Model check: max |model - evaluate()| = %.2f\n", model_error);
+    if (model_error >= 1.0) {
+        fprintf(stderr, "tune: the weight model no longer matches evaluate()\n");
+        return 1;
+    }
+
+    double k = fit_k(shards, threads, positions);
+    printf("K = %.4f, initial loss %.6f\n", k, total_loss(shards, threads, positions, k));
+
+    // Adam, with the learning rate in evaluation units
+    static double first_moment[WEIGHT_COUNT][2], second_moment[WEIGHT_COUNT][2];
+    const double learning_rate = 1.0, beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        long long epoch_start = get_time_ms();
+        for (int i = 0; i < threads; i++) {
+            shards[i].k = k;
+            shards[i].weights = (const double (*)[2])weights;
+        }
+        run_shards(shards, threads, gradient_shard);
+
+        double loss = 0;
+        for (int w = 0; w < WEIGHT_COUNT; w++) {
+            for (int phase = 0; phase < 2; phase++) {
+                double gradient = 0;
+                for (int i = 0; i < threads; i++) gradient += shards[i].gradient[w][phase];
+                gradient /= positions;
+                first_moment[w][phase] = beta1 * first_moment[w][phase] + (1 - beta1) * gradient;
+                second_moment[w][phase] = beta2 * second_moment[w][phase] + (1 - beta2) * gradient * gradient;
+                double m = first_moment[w][phase] / (1 - pow(beta1, epoch));
+                double v = second_moment[w][phase] / (1 - pow(beta2, epoch));
+                weights[w][phase] -= learning_rate * m / (sqrt(v) + epsilon);
+            }
+        }
+        for (int i = 0; i < threads; i++) loss += shards[i].loss;
+        printf("Epoch %d: loss %.6f, %lld ms\n", epoch, loss / positions, get_time_ms() - epoch_start);
+    }
+    printf("Final loss %.6f\n", total_loss(shards, threads, positions, k));
+
+    FILE* out = output_path ? fopen(output_path, "w") : stdout;
+    if (out == NULL) {
+        fprintf(stderr, "tune: can't create %s\n", output_path);
+        return 1;
+    }
+    print_weights(out);
+    if (out != stdout) fclose(out);
+
+    for (int i = 0; i < threads; i++) {
+        free(shards[i].positions);
+        free(shards[i].terms);
+    }
+    free(shards);
+    return 0;
+}